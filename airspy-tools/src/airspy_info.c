@@ -191,6 +191,13 @@ int main(int argc, char** argv)
 			}
 			free(samplerates);
 
+			printf("DSP kernels:\n");
+			for (j = 0; j < AIRSPY_DSP_END; j++)
+			{
+				printf("\t%s: %s\n", airspy_dsp_kernel_name((enum airspy_dsp_kernel) j),
+					airspy_get_dsp_kernel_variant(devices[i], (enum airspy_dsp_kernel) j));
+			}
+
 			printf("Close board %d\n", i+1);
 			result = airspy_close(devices[i]);
 			if (result != AIRSPY_SUCCESS) {
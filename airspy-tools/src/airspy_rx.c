@@ -239,6 +239,8 @@ uint64_t bytes_to_xfer = 0;
 bool call_set_packing = false;
 uint32_t packing_val = 0;
 
+bool low_latency = false;
+
 bool sample_rate = false;
 uint32_t sample_rate_val;
 
@@ -487,6 +489,7 @@ static void usage(void)
 	fprintf(stderr, "[-g linearity_gain]: Set linearity simplified gain, 0-%d\n", LINEARITY_GAIN_MAX);
 	fprintf(stderr, "[-h sensivity_gain]: Set sensitivity simplified gain, 0-%d\n", SENSITIVITY_GAIN_MAX);
 	fprintf(stderr, "[-n num_samples]: Number of samples to transfer (default is unlimited)\n");
+	fprintf(stderr, "[-L]: Low latency mode, small transfers and short queue (latency budget shown in verbose mode)\n");
 	fprintf(stderr, "[-d]: Verbose mode\n");
 }
 
@@ -536,9 +539,17 @@ int main(int argc, char** argv)
 	uint32_t sample_rate_u32;
 	uint32_t sample_type_u32;
 	double freq_hz_temp;
+	airspy_latency_t latency;
+	airspy_stats_t stats;
+	airspy_stage_timing_t stage_timing;
+	static const char* const stage_names[AIRSPY_STAGE_END] = { "convert", "filter", "callback" };
+	airspy_histogram_t histogram;
+	static const char* const histogram_names[AIRSPY_HISTOGRAM_END] = { "Queue wait (us)", "Callback (us)", "USB interval (us)", "Queue depth (buffers)" };
+	uint64_t transfer_errors;
+	int i;
 	char str[20];
 
-	while( (opt = getopt(argc, argv, "r:ws:p:f:a:t:b:v:m:l:g:h:n:d")) != EOF )
+	while( (opt = getopt(argc, argv, "r:ws:p:f:a:t:b:v:m:l:g:h:n:Ld")) != EOF )
 	{
 		result = AIRSPY_SUCCESS;
 		switch( opt ) 
@@ -678,6 +689,10 @@ int main(int argc, char** argv)
 				result = parse_u64(optarg, &samples_to_xfer);
 			break;
 
+			case 'L':
+				low_latency = true;
+			break;
+
 			case 'd':
 				verbose = true;
 			break;
@@ -940,6 +955,17 @@ int main(int argc, char** argv)
 		}
 	}
 
+	if( low_latency == true )
+	{
+		result = airspy_set_low_latency(device, 1);
+		if( result != AIRSPY_SUCCESS ) {
+			fprintf(stderr, "airspy_set_low_latency() failed: %s (%d)\n", airspy_error_name(result), result);
+			airspy_close(device);
+			airspy_exit();
+			return EXIT_FAILURE;
+		}
+	}
+
 	result = airspy_set_rf_bias(device, biast_val);
 	if( result != AIRSPY_SUCCESS ) {
 		fprintf(stderr, "airspy_set_rf_bias() failed: %s (%d)\n", airspy_error_name(result), result);
@@ -1019,6 +1045,11 @@ int main(int argc, char** argv)
 		}
 	}
 
+	if (verbose)
+	{
+		airspy_set_stage_timing(device, 1);
+	}
+
 	result = airspy_start_rx(device, rx_callback, NULL);
 	if( result != AIRSPY_SUCCESS ) {
 		fprintf(stderr, "airspy_start_rx() failed: %s (%d)\n", airspy_error_name(result), result);
@@ -1048,6 +1079,12 @@ int main(int argc, char** argv)
 		sprintf(str, "%2.3f", average_rate_now);
 		average_rate_now = 9.5f;
 		fprintf(stderr, "Streaming at %5s MSPS\n", str);
+		if (verbose)
+		{
+			airspy_get_latency(device, &latency);
+			fprintf(stderr, "Latency: transfer %u us, queue %u us (max %u us), callback %u us (max %u us)\n",
+				latency.transfer_us, latency.queue_us, latency.queue_max_us, latency.callback_us, latency.callback_max_us);
+		}
 		if ((limit_num_samples == true) && (bytes_to_xfer == 0))
 			do_exit = true;
 		else
@@ -1077,6 +1114,40 @@ int main(int argc, char** argv)
 			fprintf(stderr, "airspy_stop_rx() failed: %s (%d)\n", airspy_error_name(result), result);
 		}
 
+		if (verbose)
+		{
+			airspy_get_stats(device, &stats);
+			transfer_errors = 0;
+			for (i = 0; i < AIRSPY_TRANSFER_ERROR_END; i++)
+			{
+				transfer_errors += stats.transfer_errors[i];
+			}
+			fprintf(stderr, "Stats: %llu buffers, %llu samples, %llu overruns (queue max %llu), %llu transfer errors, %llu resubmit failures\n",
+				(unsigned long long) stats.buffers, (unsigned long long) stats.samples, (unsigned long long) stats.queue_overruns,
+				(unsigned long long) stats.queue_high_water, (unsigned long long) transfer_errors, (unsigned long long) stats.resubmit_failures);
+
+			for (i = 0; i < AIRSPY_STAGE_END; i++)
+			{
+				airspy_get_stage_timing(device, (enum airspy_stage) i, &stage_timing);
+				if (stage_timing.count > 0)
+				{
+					fprintf(stderr, "Stage %s: min %llu ns, avg %llu ns, p99 %llu ns, max %llu ns\n", stage_names[i],
+						(unsigned long long) stage_timing.min_ns, (unsigned long long) stage_timing.avg_ns,
+						(unsigned long long) stage_timing.p99_ns, (unsigned long long) stage_timing.max_ns);
+				}
+			}
+
+			for (i = 0; i < AIRSPY_HISTOGRAM_END; i++)
+			{
+				airspy_get_histogram(device, (enum airspy_histogram) i, &histogram);
+				if (histogram.count > 0)
+				{
+					fprintf(stderr, "%s: p50 %llu, p99 %llu, max %llu\n", histogram_names[i],
+						(unsigned long long) histogram.p50, (unsigned long long) histogram.p99, (unsigned long long) histogram.max);
+				}
+			}
+		}
+
 		result = airspy_close(device);
 		if( result != AIRSPY_SUCCESS ) 
 		{
@@ -26,6 +26,7 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <libusb.h>
 
 #if _MSC_VER > 1700  // To avoid error with Visual Studio 2017/2019 or more define which define timespec as it is already defined in pthread.h
@@ -34,9 +35,26 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 
 #include <pthread.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 #include "airspy.h"
 #include "iqconverter_float.h"
 #include "iqconverter_int16.h"
+#include "sample_converter.h"
+#include "cpu_features.h"
+#include "buffer_ring.h"
+#include "arena.h"
+#include "dsp_pool.h"
+#include "thread_sched.h"
+#include "histogram.h"
 #include "filters.h"
 
 #ifndef bool
@@ -48,6 +66,30 @@ typedef int bool;
 #define PACKET_SIZE (12)
 #define UNPACKED_SIZE (16)
 #define RAW_BUFFER_COUNT (8)
+#define MAX_QUEUE_DEPTH (256)
+#define MAX_TRANSFER_COUNT (64)
+#define DEFAULT_TRANSFER_COUNT (16)
+#define DEFAULT_TRANSFER_SIZE (262144)
+#define DEFAULT_PACKED_TRANSFER_SIZE (6144 * 24)
+#define MAX_TRANSFER_SIZE (4 * 1024 * 1024)
+/* Packed transfers hold whole 12 byte packets and whole 512 byte USB packets */
+#define TRANSFER_SIZE_ALIGNMENT (512)
+#define PACKED_TRANSFER_SIZE_ALIGNMENT (1536)
+/* Memory the auto-tuned queue may grow to */
+#define AUTO_TUNE_QUEUE_MEMORY (64 * 1024 * 1024)
+/* About 0.4 ms per transfer at 10 MSPS (40 MB/s unpacked), 4 queued buffers bound the queueing delay to about 1.6 ms */
+#define LOW_LATENCY_TRANSFER_COUNT (32)
+#define LOW_LATENCY_TRANSFER_SIZE (16384)
+#define LOW_LATENCY_QUEUE_DEPTH (4)
+/* Two seconds at 10 MSPS */
+#define MAX_CALLBACK_BLOCK_SIZE (20 * 1000 * 1000)
+#define MAX_POOL_COUNT (256)
+#define MAX_CONVERSION_THREADS (16)
+/* Buffers a DSP pool worker processes for one device before moving on to the next one */
+#define DISPATCH_BATCH (4)
+
+#define CONVERSION_STAGE_CONVERT (0)
+#define CONVERSION_STAGE_FILTER (1)
 
 #ifdef AIRSPY_BIG_ENDIAN
 #define TO_LE(x) __builtin_bswap32(x)
@@ -55,12 +97,6 @@ typedef int bool;
 #define TO_LE(x) x
 #endif
 
-#define SAMPLE_RESOLUTION 12
-#define SAMPLE_ENCAPSULATION 16
-
-#define SAMPLE_SHIFT (SAMPLE_ENCAPSULATION - SAMPLE_RESOLUTION)
-#define SAMPLE_SCALE (1.0f / (1 << (15 - SAMPLE_SHIFT)))
-
 #define SERIAL_NUMBER_UNUSED (0ULL)
 #define FILE_DESCRIPTOR_UNUSED (-1)
 
@@ -70,12 +106,42 @@ typedef int bool;
 #define MIN_SAMPLERATE_BY_VALUE (1000000)
 #define SAMPLE_TYPE_IS_IQ(x) ((x) == AIRSPY_SAMPLE_FLOAT32_IQ || (x) == AIRSPY_SAMPLE_INT16_IQ)
 
+#if defined(_MSC_VER)
+	#define ATOMIC_LOAD(p) (*(p))
+	#define ATOMIC_INC(p) InterlockedIncrement((volatile LONG *) (p))
+	#define ATOMIC_DEC(p) InterlockedDecrement((volatile LONG *) (p))
+	#define STAT_ADD(p, v) InterlockedExchangeAdd64((volatile LONG64 *) (p), (LONG64) (v))
+	#define STAT_STORE(p, v) InterlockedExchange64((volatile LONG64 *) (p), (LONG64) (v))
+	#define STAT_LOAD(p) ((uint64_t) InterlockedCompareExchange64((volatile LONG64 *) (p), 0, 0))
+	#define STAT_EXCHANGE(p, v) ((uint64_t) InterlockedExchange64((volatile LONG64 *) (p), (LONG64) (v)))
+#else
+	#define ATOMIC_LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+	#define ATOMIC_INC(p) __atomic_add_fetch(p, 1, __ATOMIC_ACQ_REL)
+	#define ATOMIC_DEC(p) __atomic_sub_fetch(p, 1, __ATOMIC_ACQ_REL)
+	#define STAT_ADD(p, v) __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
+	#define STAT_STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+	#define STAT_LOAD(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+	#define STAT_EXCHANGE(p, v) __atomic_exchange_n(p, v, __ATOMIC_RELAXED)
+#endif
+
 typedef struct {
 	uint32_t freq_hz;
 } set_freq_params_t;
 
+typedef struct {
+	pthread_t thread;
+	struct airspy_device* device;
+	int index;
+	iqconverter_float_t *cnv_f;
+	iqconverter_int16_t *cnv_i;
+} conversion_worker_t;
+
 typedef struct airspy_device
 {
+	struct airspy_context* context;
+	bool shared_dsp;
+	dsp_task_t dsp_task;
+	volatile long transfers_active;
 	libusb_context* usb_context;
 	libusb_device_handle* usb_device;
 	struct libusb_transfer** transfers;
@@ -84,27 +150,87 @@ typedef struct airspy_device
 	volatile bool stop_requested;
 	pthread_t transfer_thread;
 	pthread_t consumer_thread;
-	pthread_cond_t consumer_cv;
-	pthread_mutex_t consumer_mp;
 	uint32_t supported_samplerate_count;
 	uint32_t *supported_samplerates;
 	uint32_t transfer_count;
+	uint32_t transfer_size;
 	uint32_t buffer_size;
-	uint32_t dropped_buffers;
-	uint32_t dropped_buffers_queue[RAW_BUFFER_COUNT];
-	uint16_t *received_samples_queue[RAW_BUFFER_COUNT];
-	volatile int received_samples_queue_head;
-	volatile int received_samples_queue_tail;
-	volatile int received_buffer_count;
+	uint32_t queue_depth;
+	bool buffer_auto_tune;
+	buffer_ring_t received_samples;
+	int wait_strategy;
+	uint64_t last_completion_us;
+	airspy_latency_t latency;
+	airspy_stats_t stats;
+	bool stage_timing;
+	histogram_t stage_times[AIRSPY_STAGE_END];
+	histogram_t histograms[AIRSPY_HISTOGRAM_END];
+	airspy_watchdog_cb_fn watchdog;
+	void *watchdog_ctx;
+	uint32_t watchdog_budget_us;
+	volatile uint64_t callback_start_us;
+	volatile uint64_t watchdog_start_us;
 	void *output_buffer;
-	uint16_t *unpacked_samples;
+	void *conversion_output;
+	uint32_t pool_count;
+	uint32_t pool_index;
+	size_t pool_stride;
+	uint8_t *pool_base;
+	void *pool_memory;
+	size_t pool_memory_size;
+	arena_t arena;
+	arena_t usb_arena;
+	unsigned char *usb_memory;
+	size_t usb_memory_size;
+	uint32_t memory_flags;
+	int numa_node;
+	thread_sched_t thread_sched[AIRSPY_THREAD_END];
+	volatile long *pool_refs;
+	pthread_mutex_t pool_mp;
+	pthread_cond_t pool_cv;
+	uint32_t block_size;
+	uint32_t block_start;
+	uint32_t block_fill;
+	uint64_t block_dropped;
+	uint32_t pool_dropped;
+	enum airspy_sample_type block_sample_type;
+	bool event_loop;
+	bool inline_conversion;
+	bool event_signalled;
+	int event_fds[2];
+	bool pull_acquired;
+	uint32_t pull_offset;
+	airspy_transfer_t pull_transfer;
 	bool packing_enabled;
 	iqconverter_float_t *cnv_f;
 	iqconverter_int16_t *cnv_i;
 	void* ctx;
 	enum airspy_sample_type sample_type;
+	uint32_t conversion_threads;
+	conversion_worker_t conversion_workers[MAX_CONVERSION_THREADS];
+	pthread_cond_t conversion_cv;
+	pthread_cond_t conversion_done_cv;
+	pthread_mutex_t conversion_mp;
+	volatile bool conversion_stop;
+	volatile uint32_t conversion_generation;
+	volatile int conversion_pending;
+	int conversion_stage;
+	int conversion_chunks;
+	int conversion_bounds[MAX_CONVERSION_THREADS + 1];
+	const uint16_t *conversion_input;
 } airspy_device_t;
 
+/* Devices opened into a context share its libusb context and event thread */
+typedef struct airspy_context
+{
+	libusb_context* usb_context;
+	pthread_t event_thread;
+	uint32_t device_count;
+	volatile bool stop;
+	pthread_mutex_t mp;
+	pthread_cond_t idle_cv;
+} airspy_context_t;
+
 static const uint16_t airspy_usb_vid = 0x1d50;
 static const uint16_t airspy_usb_pid = 0x60a1;
 
@@ -121,6 +247,138 @@ uint8_t airspy_sensitivity_vga_gains[GAIN_COUNT] = { 13, 12, 11, 10, 9, 8, 7, 6,
 uint8_t airspy_sensitivity_mixer_gains[GAIN_COUNT] = { 12, 12, 12, 12, 11, 10, 10, 9, 9, 8, 7, 4, 4, 4, 3, 2, 2, 1, 0, 0, 0, 0 };
 uint8_t airspy_sensitivity_lna_gains[GAIN_COUNT] = { 14, 14, 14, 14, 14, 14, 14, 14, 14, 13, 12, 12, 9, 9, 8, 7, 6, 5, 3, 2, 1, 0 };
 
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000
+		+ (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static uint64_t get_time_ns(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000000
+		+ (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// Start of a timed stage, 0 when stage timing is off
+static uint64_t stage_begin(const airspy_device_t* device)
+{
+	return device->stage_timing ? get_time_ns() : 0;
+}
+
+static void stage_end(airspy_device_t* device, enum airspy_stage stage, uint64_t start_ns)
+{
+	if (start_ns != 0)
+	{
+		histogram_add(&device->stage_times[stage], get_time_ns() - start_ns);
+	}
+}
+
+#ifndef _WIN32
+
+// An eventfd on Linux, a pipe elsewhere. Either way the read end polls readable until cleared
+static int open_event_fd(airspy_device_t* device)
+{
+#ifdef __linux__
+	device->event_fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	device->event_fds[1] = device->event_fds[0];
+
+	return device->event_fds[0] < 0 ? -1 : 0;
+#else
+	if (pipe(device->event_fds) != 0)
+	{
+		return -1;
+	}
+
+	fcntl(device->event_fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(device->event_fds[1], F_SETFL, O_NONBLOCK);
+	fcntl(device->event_fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(device->event_fds[1], F_SETFD, FD_CLOEXEC);
+
+	return 0;
+#endif
+}
+
+static void close_event_fd(airspy_device_t* device)
+{
+	if (device->event_fds[0] >= 0)
+	{
+		close(device->event_fds[0]);
+	}
+	if (device->event_fds[1] >= 0 && device->event_fds[1] != device->event_fds[0])
+	{
+		close(device->event_fds[1]);
+	}
+
+	device->event_fds[0] = FILE_DESCRIPTOR_UNUSED;
+	device->event_fds[1] = FILE_DESCRIPTOR_UNUSED;
+}
+
+#endif
+
+// Event loop mode only, runs on the application thread like everything else in that mode
+static void signal_event_fd(airspy_device_t* device)
+{
+#ifndef _WIN32
+	uint64_t value = 1;
+
+	if (!device->event_signalled)
+	{
+		device->event_signalled = true;
+		if (write(device->event_fds[1], &value, sizeof(value)) < 0)
+		{
+			device->event_signalled = false;
+		}
+	}
+#else
+	(void) device;
+#endif
+}
+
+static void clear_event_fd(airspy_device_t* device)
+{
+#ifndef _WIN32
+	uint64_t value;
+
+	if (device->event_signalled)
+	{
+		device->event_signalled = false;
+		while (read(device->event_fds[0], &value, sizeof(value)) > 0)
+		{
+		}
+	}
+#else
+	(void) device;
+#endif
+}
+
 static int cancel_transfers(airspy_device_t* device)
 {
 	uint32_t transfer_index;
@@ -141,9 +399,47 @@ static int cancel_transfers(airspy_device_t* device)
 	}
 }
 
+/*
+ * On Linux, transfer buffers mapped from usbfs are read and written by the
+ * device directly instead of being copied to and from the kernel. The ring
+ * swaps buffers with the transfers, so the queued buffers come from the
+ * same mapping. Heap memory is used when the kernel cannot map any.
+ */
+static void allocate_usb_memory(airspy_device_t* device, size_t size)
+{
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+	device->usb_memory = libusb_dev_mem_alloc(device->usb_device, size);
+	if (device->usb_memory != NULL)
+	{
+		device->usb_memory_size = size;
+		arena_attach(&device->usb_arena, device->usb_memory, size);
+	}
+#else
+	(void) device;
+	(void) size;
+#endif
+}
+
+static void free_usb_memory(airspy_device_t* device)
+{
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+	if (device->usb_memory != NULL)
+	{
+		libusb_dev_mem_free(device->usb_device, device->usb_memory, device->usb_memory_size);
+	}
+#endif
+	device->usb_memory = NULL;
+	device->usb_memory_size = 0;
+	arena_free(&device->usb_arena);
+}
+
+static arena_t* get_transfer_arena(airspy_device_t* device)
+{
+	return device->usb_memory != NULL ? &device->usb_arena : &device->arena;
+}
+
 static int free_transfers(airspy_device_t* device)
 {
-	int i;
 	uint32_t transfer_index;
 
 	if (device->transfers != NULL)
@@ -153,85 +449,164 @@ static int free_transfers(airspy_device_t* device)
 		{
 			if (device->transfers[transfer_index] != NULL)
 			{
-				free(device->transfers[transfer_index]->buffer);
+				arena_release(get_transfer_arena(device), device->transfers[transfer_index]->buffer);
 				libusb_free_transfer(device->transfers[transfer_index]);
 				device->transfers[transfer_index] = NULL;
 			}
 		}
 		free(device->transfers);
 		device->transfers = NULL;
+	}
 
-		if (device->output_buffer != NULL)
-		{
-			free(device->output_buffer);
-			device->output_buffer = NULL;
-		}
-
-		if (device->unpacked_samples != NULL)
-		{
-			free(device->unpacked_samples);
-			device->unpacked_samples = NULL;
-		}
+	// Also undoes a partial allocate_transfers()
+	free((void *) device->pool_refs);
+	device->pool_base = NULL;
+	device->pool_refs = NULL;
+	device->output_buffer = NULL;
 
-		for (i = 0; i < RAW_BUFFER_COUNT; i++)
-		{
-			if (device->received_samples_queue[i] != NULL)
-			{
-				free(device->received_samples_queue[i]);
-				device->received_samples_queue[i] = NULL;
-			}
-		}
+	if (device->received_samples.entries != NULL)
+	{
+		buffer_ring_free(&device->received_samples);
 	}
+	free_usb_memory(device);
+	arena_free(&device->arena);
 
 	return AIRSPY_SUCCESS;
 }
 
-static int allocate_transfers(airspy_device_t* const device)
+static uint32_t get_buffer_size(const airspy_device_t* device)
+{
+	uint32_t alignment;
+	uint32_t size;
+
+	if (device->transfer_size == 0)
+	{
+		return device->packing_enabled ? DEFAULT_PACKED_TRANSFER_SIZE : DEFAULT_TRANSFER_SIZE;
+	}
+
+	alignment = device->packing_enabled ? PACKED_TRANSFER_SIZE_ALIGNMENT : TRANSFER_SIZE_ALIGNMENT;
+	size = device->transfer_size - device->transfer_size % alignment;
+
+	return size < alignment ? alignment : size;
+}
+
+// Room for a whole transfer behind a partial block of the largest sample type
+static size_t get_pool_stride(const airspy_device_t* device)
 {
-	int i;
 	size_t sample_count;
+	size_t size;
+
+	if (device->packing_enabled)
+	{
+		sample_count = ((device->buffer_size / 2) * 4) / 3;
+	}
+	else
+	{
+		sample_count = device->buffer_size / 2;
+	}
+
+	size = (sample_count + (size_t) device->block_size * 2) * sizeof(float);
+
+	return (size + 63) & ~(size_t) 63;
+}
+
+static uint32_t get_queue_limit(const airspy_device_t* device)
+{
+	uint32_t limit;
+
+	if (!device->buffer_auto_tune)
+	{
+		return device->queue_depth;
+	}
+
+	limit = AUTO_TUNE_QUEUE_MEMORY / device->buffer_size;
+	if (limit < device->queue_depth)
+	{
+		limit = device->queue_depth;
+	}
+
+	return limit < MAX_QUEUE_DEPTH ? limit : MAX_QUEUE_DEPTH;
+}
+
+// The buffers are mostly touched by the consumer thread, and by the transfer thread on the way in
+static int get_numa_node(const airspy_device_t* device)
+{
+	uint64_t cpu_mask;
+
+	if (device->numa_node != AIRSPY_NUMA_THREAD_NODE)
+	{
+		return device->numa_node;
+	}
+
+	cpu_mask = device->thread_sched[AIRSPY_THREAD_CONSUMER].cpu_mask;
+	if (cpu_mask == 0)
+	{
+		cpu_mask = device->thread_sched[AIRSPY_THREAD_TRANSFER].cpu_mask;
+	}
+
+	return thread_sched_mask_node(cpu_mask);
+}
+
+static int allocate_transfers(airspy_device_t* const device)
+{
 	uint32_t transfer_index;
+	size_t arena_size;
+	size_t usb_size;
 
 	if (device->transfers == NULL)
 	{
-		for (i = 0; i < RAW_BUFFER_COUNT; i++)
+		device->pool_stride = get_pool_stride(device);
+		if (device->pool_memory != NULL && device->pool_memory_size < device->pool_stride * device->pool_count)
 		{
-			device->received_samples_queue[i] = (uint16_t *)malloc(device->buffer_size);
-			if (device->received_samples_queue[i] == NULL)
-			{
-				return AIRSPY_ERROR_NO_MEM;
-			}
-
-			memset(device->received_samples_queue[i], 0, device->buffer_size);
+			return AIRSPY_ERROR_NO_MEM;
 		}
 
-		if (device->packing_enabled)
+		// Transfers and queued buffers in usbfs memory if possible, else along with the output pool.
+		// Buffers added by auto-tuning use the slack, then the heap
+		usb_size = arena_block_size(device->buffer_size) * (device->transfer_count + device->queue_depth);
+		allocate_usb_memory(device, usb_size);
+
+		arena_size = device->usb_memory != NULL ? 0 : usb_size;
+		if (device->pool_memory == NULL)
 		{
-			sample_count = ((device->buffer_size / 2) * 4) / 3;
+			arena_size += device->pool_stride * device->pool_count;
 		}
-		else
+
+		if (arena_init(&device->arena, arena_size, device->memory_flags, get_numa_node(device)) != 0)
 		{
-			sample_count = device->buffer_size / 2;
+			free_transfers(device);
+			return AIRSPY_ERROR_NO_MEM;
 		}
 
-		device->output_buffer = (float *)malloc(sample_count * sizeof(float));
-		if (device->output_buffer == NULL)
+		if (buffer_ring_init(&device->received_samples, device->queue_depth, get_queue_limit(device), device->buffer_size, get_transfer_arena(device)) != 0)
 		{
+			free_transfers(device);
 			return AIRSPY_ERROR_NO_MEM;
 		}
 
-		if (device->packing_enabled)
+		if (device->pool_memory != NULL)
 		{
-			device->unpacked_samples = (uint16_t*)malloc(sample_count * sizeof(uint16_t));
-			if (device->unpacked_samples == NULL)
-			{
-				return AIRSPY_ERROR_NO_MEM;
-			}
+			device->pool_base = (uint8_t *) device->pool_memory;
+		}
+		else
+		{
+			device->pool_base = (uint8_t *) arena_alloc(&device->arena, device->pool_stride * device->pool_count);
+		}
+
+		device->pool_refs = (volatile long *) calloc(device->pool_count, sizeof(long));
+		if (device->pool_base == NULL || device->pool_refs == NULL)
+		{
+			free_transfers(device);
+			return AIRSPY_ERROR_NO_MEM;
 		}
 
+		device->pool_index = 0;
+		device->output_buffer = device->pool_base;
+
 		device->transfers = (struct libusb_transfer**) calloc(device->transfer_count, sizeof(struct libusb_transfer));
 		if (device->transfers == NULL)
 		{
+			free_transfers(device);
 			return AIRSPY_ERROR_NO_MEM;
 		}
 
@@ -240,6 +615,7 @@ static int allocate_transfers(airspy_device_t* const device)
 			device->transfers[transfer_index] = libusb_alloc_transfer(0);
 			if (device->transfers[transfer_index] == NULL)
 			{
+				free_transfers(device);
 				return AIRSPY_ERROR_LIBUSB;
 			}
 
@@ -247,7 +623,7 @@ static int allocate_transfers(airspy_device_t* const device)
 				device->transfers[transfer_index],
 				device->usb_device,
 				0,
-				(unsigned char*)malloc(device->buffer_size),
+				(unsigned char*)arena_alloc(get_transfer_arena(device), device->buffer_size),
 				device->buffer_size,
 				NULL,
 				device,
@@ -256,6 +632,7 @@ static int allocate_transfers(airspy_device_t* const device)
 
 			if (device->transfers[transfer_index]->buffer == NULL)
 			{
+				free_transfers(device);
 				return AIRSPY_ERROR_NO_MEM;
 			}
 		}
@@ -267,6 +644,32 @@ static int allocate_transfers(airspy_device_t* const device)
 	}
 }
 
+static int reallocate_transfers(airspy_device_t* device, uint32_t transfer_count, uint32_t transfer_size, uint32_t queue_depth)
+{
+	int result;
+
+	if (device->streaming)
+	{
+		return AIRSPY_ERROR_BUSY;
+	}
+
+	cancel_transfers(device);
+	free_transfers(device);
+
+	device->transfer_count = transfer_count;
+	device->transfer_size = transfer_size;
+	device->queue_depth = queue_depth;
+	device->buffer_size = get_buffer_size(device);
+
+	result = allocate_transfers(device);
+	if (result != 0)
+	{
+		return AIRSPY_ERROR_NO_MEM;
+	}
+
+	return AIRSPY_SUCCESS;
+}
+
 static int prepare_transfers(airspy_device_t* device, const uint_fast8_t endpoint_address, libusb_transfer_cb_fn callback)
 {
 	int error;
@@ -283,6 +686,7 @@ static int prepare_transfers(airspy_device_t* device, const uint_fast8_t endpoin
 			{
 				return AIRSPY_ERROR_LIBUSB;
 			}
+			ATOMIC_INC(&device->transfers_active);
 		}
 		return AIRSPY_SUCCESS;
 	}
@@ -292,864 +696,2274 @@ static int prepare_transfers(airspy_device_t* device, const uint_fast8_t endpoin
 	}
 }
 
-static void convert_samples_int16(uint16_t *src, int16_t *dest, int count)
+// Converts sample_count samples starting at output sample first, which shall be a multiple of 8
+static void convert_float(airspy_device_t* device, const uint16_t* input_samples, int first, int sample_count)
 {
-	int i;
-	for (i = 0; i < count; i += 4)
+	float *output = (float *) device->conversion_output + first;
+
+	if (device->packing_enabled)
 	{
-		dest[i + 0] = (src[i + 0] - 2048) << SAMPLE_SHIFT;
-		dest[i + 1] = (src[i + 1] - 2048) << SAMPLE_SHIFT;
-		dest[i + 2] = (src[i + 2] - 2048) << SAMPLE_SHIFT;
-		dest[i + 3] = (src[i + 3] - 2048) << SAMPLE_SHIFT;
+		unpack_convert_float((const uint32_t *) input_samples + first / 8 * 3, output, sample_count);
 	}
-}
-
-static void convert_samples_float(uint16_t *src, float *dest, int count)
-{
-	int i;
-	for (i = 0; i < count; i += 4)
+	else
 	{
-		dest[i + 0] = (src[i + 0] - 2048) * SAMPLE_SCALE;
-		dest[i + 1] = (src[i + 1] - 2048) * SAMPLE_SCALE;
-		dest[i + 2] = (src[i + 2] - 2048) * SAMPLE_SCALE;
-		dest[i + 3] = (src[i + 3] - 2048) * SAMPLE_SCALE;
+		convert_samples_float(input_samples + first, output, sample_count);
 	}
 }
 
-static inline void unpack_samples(uint32_t *input, uint16_t *output, int length)
+static void convert_int16(airspy_device_t* device, const uint16_t* input_samples, int first, int sample_count)
 {
-	int i, j;
+	int16_t *output = (int16_t *) device->conversion_output + first;
 
-	for (i = 0, j = 0; j < length; i += 3, j += 8)
+	if (device->packing_enabled)
+	{
+		unpack_convert_int16((const uint32_t *) input_samples + first / 8 * 3, output, sample_count);
+	}
+	else
 	{
-		output[j + 0] = (input[i] >> 20) & 0xfff;
-		output[j + 1] = (input[i] >> 8) & 0xfff;
-		output[j + 2] = ((input[i] & 0xff) << 4) | ((input[i + 1] >> 28) & 0xf);
-		output[j + 3] = ((input[i + 1] & 0xfff0000) >> 16);
-		output[j + 4] = ((input[i + 1] & 0xfff0) >> 4);
-		output[j + 5] = ((input[i + 1] & 0xf) << 8) | ((input[i + 2] & 0xff000000) >> 24);
-		output[j + 6] = ((input[i + 2] >> 12) & 0xfff);
-		output[j + 7] = ((input[i + 2] & 0xfff));
+		convert_samples_int16(input_samples + first, output, sample_count);
 	}
 }
 
-static void* consumer_threadproc(void *arg)
+static void run_conversion_chunk(airspy_device_t* device, int index)
 {
-	int sample_count;
-	uint16_t* input_samples;
-	uint32_t dropped_buffers;
-	airspy_device_t* device = (airspy_device_t*)arg;
-	airspy_transfer_t transfer;
-
-#ifdef _WIN32
-
-	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
-
-#endif
-
-	pthread_mutex_lock(&device->consumer_mp);
+	conversion_worker_t* worker = &device->conversion_workers[index];
+	int first = device->conversion_bounds[index];
+	int count = device->conversion_bounds[index + 1] - first;
 
-	while (device->streaming && !device->stop_requested)
+	switch (device->sample_type)
 	{
-		while (device->received_buffer_count == 0 && device->streaming && !device->stop_requested)
+	case AIRSPY_SAMPLE_FLOAT32_IQ:
+		if (device->conversion_stage == CONVERSION_STAGE_CONVERT)
 		{
-			pthread_cond_wait(&device->consumer_cv, &device->consumer_mp);
+			convert_float(device, device->conversion_input, first, count);
 		}
-		if (!device->streaming || device->stop_requested)
+		else
 		{
-			break;
+			iqconverter_float_filter(worker->cnv_f, (float *) device->conversion_output + first, count);
 		}
+		break;
 
-		input_samples = device->received_samples_queue[device->received_samples_queue_tail];
-		dropped_buffers = device->dropped_buffers_queue[device->received_samples_queue_tail];
-		device->received_samples_queue_tail = (device->received_samples_queue_tail + 1) & (RAW_BUFFER_COUNT - 1);
-
-		pthread_mutex_unlock(&device->consumer_mp);
-
-		if (device->packing_enabled)
+	case AIRSPY_SAMPLE_INT16_IQ:
+		if (device->conversion_stage == CONVERSION_STAGE_CONVERT)
 		{
-			sample_count = ((device->buffer_size / 2) * 4) / 3;
-
-			if (device->sample_type != AIRSPY_SAMPLE_RAW)
-			{
-				unpack_samples((uint32_t*)input_samples, device->unpacked_samples, sample_count);
-
-				input_samples = device->unpacked_samples;
-			}
+			convert_int16(device, device->conversion_input, first, count);
 		}
 		else
 		{
-			sample_count = device->buffer_size / 2;
+			iqconverter_int16_filter(worker->cnv_i, (int16_t *) device->conversion_output + first, count);
 		}
+		break;
 
-		switch (device->sample_type)
-		{
-		case AIRSPY_SAMPLE_FLOAT32_IQ:
-			convert_samples_float(input_samples, (float *)device->output_buffer, sample_count);
-			iqconverter_float_process(device->cnv_f, (float *) device->output_buffer, sample_count);
-			sample_count /= 2;
-			transfer.samples = device->output_buffer;
-			break;
-
-		case AIRSPY_SAMPLE_FLOAT32_REAL:
-			convert_samples_float(input_samples, (float *)device->output_buffer, sample_count);
-			transfer.samples = device->output_buffer;
-			break;
+	default:
+		break;
+	}
+}
 
-		case AIRSPY_SAMPLE_INT16_IQ:
-			convert_samples_int16(input_samples, (int16_t *)device->output_buffer, sample_count);
-			iqconverter_int16_process(device->cnv_i, (int16_t *) device->output_buffer, sample_count);
-			sample_count /= 2;
-			transfer.samples = device->output_buffer;
-			break;
+static void* conversion_threadproc(void *arg)
+{
+	conversion_worker_t* worker = (conversion_worker_t*)arg;
+	airspy_device_t* device = worker->device;
+	uint32_t generation = 0;
 
-		case AIRSPY_SAMPLE_INT16_REAL:
-			convert_samples_int16(input_samples, (int16_t *)device->output_buffer, sample_count);
-			transfer.samples = device->output_buffer;
-			break;
+	thread_sched_apply(&device->thread_sched[AIRSPY_THREAD_CONVERSION]);
 
-		case AIRSPY_SAMPLE_UINT16_REAL:
-		case AIRSPY_SAMPLE_RAW:
-			transfer.samples = input_samples;
-			break;
+	pthread_mutex_lock(&device->conversion_mp);
 
-		case AIRSPY_SAMPLE_END:
-			// Just to shut GCC's moaning
-			break;
+	while (!device->conversion_stop)
+	{
+		if (device->conversion_generation == generation)
+		{
+			pthread_cond_wait(&device->conversion_cv, &device->conversion_mp);
+			continue;
 		}
+		generation = device->conversion_generation;
 
-		transfer.device = device;
-		transfer.ctx = device->ctx;
-		transfer.sample_count = sample_count;
-		transfer.sample_type = device->sample_type;
-		transfer.dropped_samples = (uint64_t) dropped_buffers * (uint64_t) sample_count;
-
-		if (device->callback(&transfer) != 0)
+		if (worker->index < device->conversion_chunks)
 		{
-			device->stop_requested = true;
-		}
+			pthread_mutex_unlock(&device->conversion_mp);
+			run_conversion_chunk(device, worker->index);
+			pthread_mutex_lock(&device->conversion_mp);
 
-		pthread_mutex_lock(&device->consumer_mp);
-		device->received_buffer_count--;
-	}
+			if (--device->conversion_pending == 0)
+			{
+				pthread_cond_signal(&device->conversion_done_cv);
+			}
+		}
+	}
 
-	pthread_mutex_unlock(&device->consumer_mp);
+	pthread_mutex_unlock(&device->conversion_mp);
 
 	pthread_exit(NULL);
 
 	return NULL;
 }
 
-static void airspy_libusb_transfer_callback(struct libusb_transfer* usb_transfer)
+// Runs one stage on all chunks, the calling thread takes chunk 0
+static void run_conversion_stage(airspy_device_t* device, int stage)
 {
-	uint16_t *temp;
-	airspy_device_t* device = (airspy_device_t*)usb_transfer->user_data;
+	pthread_mutex_lock(&device->conversion_mp);
+	device->conversion_stage = stage;
+	device->conversion_pending = device->conversion_chunks - 1;
+	device->conversion_generation++;
+	pthread_cond_broadcast(&device->conversion_cv);
+	pthread_mutex_unlock(&device->conversion_mp);
 
-	if (!device->streaming || device->stop_requested)
+	run_conversion_chunk(device, 0);
+
+	pthread_mutex_lock(&device->conversion_mp);
+	while (device->conversion_pending > 0)
 	{
-		return;
+		pthread_cond_wait(&device->conversion_done_cv, &device->conversion_mp);
 	}
+	pthread_mutex_unlock(&device->conversion_mp);
+}
 
-	if (usb_transfer->status == LIBUSB_TRANSFER_COMPLETED && usb_transfer->actual_length == usb_transfer->length)
+/*
+ * Same output as the single threaded path: conversion and filtering run
+ * in parallel chunks, the DC removal is recursive and stays sequential.
+ * It also runs before any chunk is filtered in place, so every filter can
+ * be seeded with the history preceding its chunk.
+ */
+static void convert_iq_parallel(airspy_device_t* device, const uint16_t* input_samples, int sample_count)
+{
+	int i;
+	int history;
+	float *samples_f;
+	int16_t *samples_i;
+	uint64_t start_ns;
+
+	if (device->sample_type == AIRSPY_SAMPLE_FLOAT32_IQ)
+	{
+		history = iqconverter_float_history_size(device->cnv_f);
+		device->conversion_chunks = iqconverter_float_split(device->cnv_f, sample_count, device->conversion_threads, device->conversion_bounds);
+	}
+	else
 	{
-		pthread_mutex_lock(&device->consumer_mp);
+		history = iqconverter_int16_history_size(device->cnv_i);
+		device->conversion_chunks = iqconverter_int16_split(device->cnv_i, sample_count, device->conversion_threads, device->conversion_bounds);
+	}
 
-		if (device->received_buffer_count < RAW_BUFFER_COUNT)
-		{
-			temp = device->received_samples_queue[device->received_samples_queue_head];
-			device->received_samples_queue[device->received_samples_queue_head] = (uint16_t *)usb_transfer->buffer;
-			usb_transfer->buffer = (uint8_t *)temp;
+	device->conversion_input = input_samples;
+	start_ns = stage_begin(device);
+	run_conversion_stage(device, CONVERSION_STAGE_CONVERT);
+	stage_end(device, AIRSPY_STAGE_CONVERT, start_ns);
+	start_ns = stage_begin(device);
 
-			device->dropped_buffers_queue[device->received_samples_queue_head] = device->dropped_buffers;
-			device->dropped_buffers = 0;
-			
-			device->received_samples_queue_head = (device->received_samples_queue_head + 1) & (RAW_BUFFER_COUNT - 1);
-			device->received_buffer_count++;
+	if (history > sample_count)
+	{
+		history = sample_count;
+	}
+
+	if (device->sample_type == AIRSPY_SAMPLE_FLOAT32_IQ)
+	{
+		samples_f = (float *) device->conversion_output;
 
-			pthread_cond_signal(&device->consumer_cv);
+		iqconverter_float_remove_dc(device->cnv_f, samples_f, sample_count);
+		iqconverter_float_copy_history(device->conversion_workers[0].cnv_f, device->cnv_f);
+		for (i = 1; i < device->conversion_chunks; i++)
+		{
+			iqconverter_float_load_history(device->conversion_workers[i].cnv_f, samples_f + device->conversion_bounds[i] - history, history);
 		}
-		else
+		// Leaves the device converter ready for the next buffer
+		iqconverter_float_load_history(device->cnv_f, samples_f + sample_count - history, history);
+	}
+	else
+	{
+		samples_i = (int16_t *) device->conversion_output;
+
+		iqconverter_int16_remove_dc(device->cnv_i, samples_i, sample_count);
+		iqconverter_int16_copy_history(device->conversion_workers[0].cnv_i, device->cnv_i);
+		for (i = 1; i < device->conversion_chunks; i++)
 		{
-			device->dropped_buffers++;
+			iqconverter_int16_load_history(device->conversion_workers[i].cnv_i, samples_i + device->conversion_bounds[i] - history, history);
 		}
+		iqconverter_int16_load_history(device->cnv_i, samples_i + sample_count - history, history);
+	}
+
+	run_conversion_stage(device, CONVERSION_STAGE_FILTER);
+	stage_end(device, AIRSPY_STAGE_FILTER, start_ns);
+}
 
-		pthread_mutex_unlock(&device->consumer_mp);
+static uint32_t find_free_pool_buffer(const airspy_device_t* device)
+{
+	uint32_t i;
 
-		if (libusb_submit_transfer(usb_transfer) != 0)
+	for (i = 0; i < device->pool_count; i++)
+	{
+		if (i != device->pool_index && ATOMIC_LOAD(&device->pool_refs[i]) == 0)
 		{
-			device->stop_requested = true;
+			break;
 		}
 	}
-	else
+
+	return i;
+}
+
+static uint32_t wait_free_pool_buffer(airspy_device_t* device)
+{
+	uint32_t i = device->pool_count;
+
+	pthread_mutex_lock(&device->pool_mp);
+	while (!device->stop_requested)
 	{
-		device->stop_requested = true;
+		i = find_free_pool_buffer(device);
+		if (i < device->pool_count)
+		{
+			break;
+		}
+
+		pthread_cond_wait(&device->pool_cv, &device->pool_mp);
 	}
+	pthread_mutex_unlock(&device->pool_mp);
+
+	return i;
 }
 
-static void* transfer_threadproc(void* arg)
+// The callback runs on the DSP pool instead of a consumer thread of its own
+static bool uses_dispatch(const airspy_device_t* device)
 {
-	airspy_device_t* device = (airspy_device_t*)arg;
-	int error;
-	struct timeval timeout = { 0, 500000 };
-
-#ifdef _WIN32
+	return device->callback != NULL && !device->event_loop && !device->inline_conversion && (device->context != NULL || device->shared_dsp);
+}
 
-	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+/*
+ * Only the consumer thread waits for a retained buffer to be released. The USB thread (inline
+ * conversion), airspy_process_events() and the pull mode caller may be the very thread that releases
+ * it, and a DSP pool worker is shared with other devices, so they never wait.
+ */
+static bool may_wait_for_pool(const airspy_device_t* device)
+{
+	return device->callback != NULL && !device->inline_conversion && !device->event_loop && !uses_dispatch(device);
+}
 
-#endif
+/*
+ * Makes device->output_buffer writable, with the partial block if any at its start.
+ * AIRSPY_ERROR_STREAMING_STOPPED once stopping, AIRSPY_ERROR_BUSY when every pool buffer is retained and this thread may not wait
+ */
+static int prepare_output_buffer(airspy_device_t* device, int sample_size)
+{
+	uint32_t next;
+	uint8_t *leftover = (uint8_t *) device->output_buffer + (size_t) device->block_start * sample_size;
 
-	while (device->streaming && !device->stop_requested)
+	if (device->pool_count > 1 && ATOMIC_LOAD(&device->pool_refs[device->pool_index]) != 0)
 	{
-		error = libusb_handle_events_timeout_completed(device->usb_context, &timeout, NULL);
-		if (error < 0)
+		next = may_wait_for_pool(device) ? wait_free_pool_buffer(device) : find_free_pool_buffer(device);
+		if (next >= device->pool_count)
 		{
-			if (error != LIBUSB_ERROR_INTERRUPTED)
-				device->stop_requested = true;
+			return device->stop_requested ? AIRSPY_ERROR_STREAMING_STOPPED : AIRSPY_ERROR_BUSY;
 		}
+
+		device->pool_index = next;
+		device->output_buffer = device->pool_base + next * device->pool_stride;
+		memcpy(device->output_buffer, leftover, (size_t) device->block_fill * sample_size);
+	}
+	else if (device->block_start > 0)
+	{
+		memmove(device->output_buffer, leftover, (size_t) device->block_fill * sample_size);
 	}
 
-	pthread_exit(NULL);
+	device->block_start = 0;
 
-	return NULL;
+	return AIRSPY_SUCCESS;
 }
 
-static int kill_io_threads(airspy_device_t* device)
+// Retained samples shall be in the pool, not in a USB buffer that goes back to the ring
+static void* pass_through_samples(airspy_device_t* device, uint16_t* input_samples)
 {
-	struct timeval timeout = { 0, 0 };
+	if (device->pool_count > 1)
+	{
+		memcpy(device->conversion_output, input_samples, device->buffer_size);
+		return device->conversion_output;
+	}
 
-	if (device->streaming)
+	return input_samples;
+}
+
+static uint32_t find_pool_buffer(const airspy_device_t* device, const void* samples)
+{
+	const uint8_t *p = (const uint8_t *) samples;
+
+	if (device->pool_base == NULL || p < device->pool_base || p >= device->pool_base + device->pool_stride * device->pool_count)
 	{
-		device->stop_requested = true;
-		cancel_transfers(device);
+		return device->pool_count;
+	}
+
+	return (uint32_t) ((size_t) (p - device->pool_base) / device->pool_stride);
+}
 
-		pthread_mutex_lock(&device->consumer_mp);
-		pthread_cond_signal(&device->consumer_cv);
-		pthread_mutex_unlock(&device->consumer_mp);
+static int get_output_sample_size(enum airspy_sample_type sample_type)
+{
+	switch (sample_type)
+	{
+	case AIRSPY_SAMPLE_FLOAT32_IQ:
+		return 2 * sizeof(float);
 
-		pthread_join(device->transfer_thread, NULL);
-		pthread_join(device->consumer_thread, NULL);
+	case AIRSPY_SAMPLE_FLOAT32_REAL:
+		return sizeof(float);
 
-		libusb_handle_events_timeout_completed(device->usb_context, &timeout, NULL);
+	case AIRSPY_SAMPLE_INT16_IQ:
+		return 2 * sizeof(int16_t);
 
-		device->stop_requested = false;
-		device->streaming = false;
+	default:
+		return sizeof(int16_t);
 	}
-
-	return AIRSPY_SUCCESS;
 }
 
-static int create_io_threads(airspy_device_t* device, airspy_sample_block_cb_fn callback)
+// Converts one USB buffer into device->conversion_output, returns the samples to deliver
+static void* convert_buffer(airspy_device_t* device, enum airspy_sample_type sample_type, uint16_t* input_samples, int* output_count)
 {
-	int result;
-	pthread_attr_t attr;
+	int sample_count;
+	uint64_t start_ns;
 
-	if (!device->streaming && !device->stop_requested)
+	if (device->packing_enabled)
 	{
-		device->callback = callback;
-		device->streaming = true;
+		sample_count = ((device->buffer_size / 2) * 4) / 3;
+	}
+	else
+	{
+		sample_count = device->buffer_size / 2;
+	}
 
-		result = prepare_transfers(device, LIBUSB_ENDPOINT_IN | 1, (libusb_transfer_cb_fn)airspy_libusb_transfer_callback);
-		if (result != AIRSPY_SUCCESS)
+	*output_count = sample_count;
+
+	switch (sample_type)
+	{
+	case AIRSPY_SAMPLE_FLOAT32_IQ:
+		if (device->conversion_threads > 1)
 		{
-			return result;
+			convert_iq_parallel(device, input_samples, sample_count);
 		}
+		else
+		{
+			start_ns = stage_begin(device);
+			convert_float(device, input_samples, 0, sample_count);
+			stage_end(device, AIRSPY_STAGE_CONVERT, start_ns);
+			start_ns = stage_begin(device);
+			iqconverter_float_process(device->cnv_f, (float *) device->conversion_output, sample_count);
+			stage_end(device, AIRSPY_STAGE_FILTER, start_ns);
+		}
+		*output_count = sample_count / 2;
+		return device->conversion_output;
 
-		device->received_samples_queue_head = 0;
-		device->received_samples_queue_tail = 0;
-		device->received_buffer_count = 0;
+	case AIRSPY_SAMPLE_FLOAT32_REAL:
+		start_ns = stage_begin(device);
+		convert_float(device, input_samples, 0, sample_count);
+		stage_end(device, AIRSPY_STAGE_CONVERT, start_ns);
+		return device->conversion_output;
 
-		pthread_attr_init(&attr);
-		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	case AIRSPY_SAMPLE_INT16_IQ:
+		if (device->conversion_threads > 1)
+		{
+			convert_iq_parallel(device, input_samples, sample_count);
+		}
+		else
+		{
+			start_ns = stage_begin(device);
+			convert_int16(device, input_samples, 0, sample_count);
+			stage_end(device, AIRSPY_STAGE_CONVERT, start_ns);
+			start_ns = stage_begin(device);
+			iqconverter_int16_process(device->cnv_i, (int16_t *) device->conversion_output, sample_count);
+			stage_end(device, AIRSPY_STAGE_FILTER, start_ns);
+		}
+		*output_count = sample_count / 2;
+		return device->conversion_output;
 
-		result = pthread_create(&device->consumer_thread, &attr, consumer_threadproc, device);
-		if (result != 0)
+	case AIRSPY_SAMPLE_INT16_REAL:
+		start_ns = stage_begin(device);
+		convert_int16(device, input_samples, 0, sample_count);
+		stage_end(device, AIRSPY_STAGE_CONVERT, start_ns);
+		return device->conversion_output;
+
+	case AIRSPY_SAMPLE_UINT16_REAL:
+		if (device->packing_enabled)
 		{
-			return AIRSPY_ERROR_THREAD;
+			start_ns = stage_begin(device);
+			unpack_samples((const uint32_t *) input_samples, (uint16_t *) device->conversion_output, sample_count);
+			stage_end(device, AIRSPY_STAGE_CONVERT, start_ns);
+			return device->conversion_output;
 		}
+		return pass_through_samples(device, input_samples);
 
-		result = pthread_create(&device->transfer_thread, &attr, transfer_threadproc, device);
-		if (result != 0)
+	default:
+		return pass_through_samples(device, input_samples);
+	}
+}
+
+// Once per slow call, from whichever of the USB and callback threads notices first
+static void fire_watchdog(airspy_device_t* device, uint64_t start_us, uint64_t elapsed_us)
+{
+	if (STAT_EXCHANGE(&device->watchdog_start_us, start_us) != start_us)
+	{
+		device->watchdog(device, device->watchdog_ctx, elapsed_us < UINT32_MAX ? (uint32_t) elapsed_us : UINT32_MAX);
+	}
+}
+
+// USB thread: the callback in progress, if any, is over budget
+static void check_watchdog(airspy_device_t* device, uint64_t now_us)
+{
+	uint64_t start_us = STAT_LOAD(&device->callback_start_us);
+
+	if (start_us != 0 && now_us > start_us + device->watchdog_budget_us)
+	{
+		fire_watchdog(device, start_us, now_us - start_us);
+	}
+}
+
+// Runs the user callback, returns non zero once it asked to stop
+static int invoke_callback(airspy_device_t* device, airspy_transfer_t* transfer)
+{
+	int result;
+	uint64_t start_ns;
+	uint64_t elapsed_ns;
+
+	STAT_ADD(&device->stats.samples, transfer->sample_count);
+
+	start_ns = get_time_ns();
+	if (device->watchdog != NULL)
+	{
+		STAT_STORE(&device->callback_start_us, start_ns / 1000);
+	}
+
+	result = device->callback(transfer);
+
+	elapsed_ns = get_time_ns() - start_ns;
+	if (device->watchdog != NULL)
+	{
+		STAT_STORE(&device->callback_start_us, 0);
+		if (elapsed_ns / 1000 > device->watchdog_budget_us)
 		{
-			return AIRSPY_ERROR_THREAD;
+			fire_watchdog(device, start_ns / 1000, elapsed_ns / 1000);
 		}
+	}
 
-		pthread_attr_destroy(&attr);
+	if (device->stage_timing)
+	{
+		histogram_add(&device->stage_times[AIRSPY_STAGE_CALLBACK], elapsed_ns);
 	}
-	else {
-		return AIRSPY_ERROR_BUSY;
+	histogram_add(&device->histograms[AIRSPY_HISTOGRAM_CALLBACK], elapsed_ns / 1000);
+
+	if (result != 0)
+	{
+		STAT_ADD(&device->stats.callback_stops, 1);
+		device->stop_requested = true;
 	}
 
-	return AIRSPY_SUCCESS;
+	return result;
 }
 
-static void airspy_open_exit(airspy_device_t* device)
+/*
+ * Fixed size blocks are converted straight into the block buffer behind
+ * the samples left over from the previous buffer, then delivered in place.
+ * Only the last partial block gets moved back to the start, or into the
+ * next pool buffer when a callback retained this one.
+ */
+static void deliver_blocks(airspy_device_t* device, airspy_transfer_t* transfer, void* samples, int sample_count, uint64_t dropped_samples)
 {
-	if (device->usb_device != NULL)
+	int sample_size = get_output_sample_size(transfer->sample_type);
+	uint8_t *block_buffer = (uint8_t *) device->output_buffer;
+	uint32_t offset = 0;
+
+	if (samples != device->conversion_output)
 	{
-		libusb_release_interface(device->usb_device, 0);
-		libusb_close(device->usb_device);
-		device->usb_device = NULL;
+		memcpy(device->conversion_output, samples, sample_count * sample_size);
 	}
-	libusb_exit(device->usb_context);
-	device->usb_context = NULL;
+
+	device->block_fill += sample_count;
+	device->block_dropped += dropped_samples;
+
+	while (device->block_fill - offset >= device->block_size)
+	{
+		transfer->samples = block_buffer + (size_t) offset * sample_size;
+		transfer->sample_count = device->block_size;
+		transfer->dropped_samples = device->block_dropped;
+		device->block_dropped = 0;
+		offset += device->block_size;
+
+		if (invoke_callback(device, transfer) != 0)
+		{
+			break;
+		}
+	}
+
+	// Moved by prepare_output_buffer() once the delivered blocks are no longer in use
+	device->block_start = offset;
+	device->block_fill -= offset;
 }
 
-static void airspy_open_device(airspy_device_t* device,
-	int* ret,
-	uint16_t vid,
-	uint16_t pid,
-	uint64_t serial_number_val)
+// Converts one USB buffer and hands it to the callback, on the consumer thread or in airspy_process_events()
+static void process_buffer(airspy_device_t* device, uint16_t* input_samples, uint32_t dropped_buffers, uint64_t timestamp)
 {
-	int i;
+	int sample_count;
 	int result;
-	libusb_device_handle** libusb_dev_handle;
-	int serial_number_len;
-	libusb_device_handle* dev_handle;
-	libusb_device *dev;
-	libusb_device** devices = NULL;
+	uint64_t start_us;
+	uint32_t elapsed_us;
+	bool use_blocks;
+	enum airspy_sample_type sample_type;
+	airspy_transfer_t transfer;
 
-	ssize_t cnt;
-	int serial_descriptor_index;
-	struct libusb_device_descriptor device_descriptor;
-	unsigned char serial_number[SERIAL_AIRSPY_EXPECTED_SIZE + 1];
+	start_us = get_time_us();
+	elapsed_us = (uint32_t) (start_us - timestamp);
+	device->latency.queue_us = elapsed_us;
+	if (elapsed_us > device->latency.queue_max_us)
+	{
+		device->latency.queue_max_us = elapsed_us;
+	}
+	histogram_add(&device->histograms[AIRSPY_HISTOGRAM_QUEUE_WAIT], elapsed_us);
 
-	libusb_dev_handle = &device->usb_device;
-	*libusb_dev_handle = NULL;
+	sample_type = device->sample_type;
+	use_blocks = device->block_size != 0 && sample_type != AIRSPY_SAMPLE_RAW;
 
-	cnt = libusb_get_device_list(device->usb_context, &devices);
-	if (cnt < 0)
+	// A partial block of another sample type cannot be completed
+	if (!use_blocks || sample_type != device->block_sample_type)
 	{
-		*ret = AIRSPY_ERROR_NOT_FOUND;
+		device->block_fill = 0;
+		device->block_sample_type = sample_type;
+	}
+
+	result = prepare_output_buffer(device, get_output_sample_size(sample_type));
+	if (result != AIRSPY_SUCCESS)
+	{
+		if (result == AIRSPY_ERROR_BUSY)
+		{
+			// Dropped, reported along with the drops before it to the next callback
+			STAT_ADD(&device->stats.pool_overruns, 1);
+			device->pool_dropped += dropped_buffers + 1;
+		}
 		return;
 	}
 
-	i = 0;
-	while ((dev = devices[i++]) != NULL)
+	dropped_buffers += device->pool_dropped;
+	device->pool_dropped = 0;
+
+	device->conversion_output = (uint8_t *) device->output_buffer + (size_t) device->block_fill * get_output_sample_size(sample_type);
+
+	transfer.samples = convert_buffer(device, sample_type, input_samples, &sample_count);
+	transfer.device = device;
+	transfer.ctx = device->ctx;
+	transfer.sample_type = sample_type;
+
+	if (use_blocks)
 	{
-		libusb_get_device_descriptor(dev, &device_descriptor);
+		deliver_blocks(device, &transfer, transfer.samples, sample_count, (uint64_t) dropped_buffers * (uint64_t) sample_count);
+	}
+	else
+	{
+		transfer.sample_count = sample_count;
+		transfer.dropped_samples = (uint64_t) dropped_buffers * (uint64_t) sample_count;
 
-		if ((device_descriptor.idVendor == vid) &&
-			(device_descriptor.idProduct == pid))
-		{
-			if (serial_number_val != SERIAL_NUMBER_UNUSED)
-			{
-				serial_descriptor_index = device_descriptor.iSerialNumber;
-				if (serial_descriptor_index > 0)
-				{
-					if (libusb_open(dev, libusb_dev_handle) != 0)
-					{
-						*libusb_dev_handle = NULL;
-						continue;
-					}
-					dev_handle = *libusb_dev_handle;
-					serial_number_len = libusb_get_string_descriptor_ascii(dev_handle,
-						serial_descriptor_index,
-						serial_number,
-						sizeof(serial_number));
-					if (serial_number_len == SERIAL_AIRSPY_EXPECTED_SIZE)
-					{
-						uint64_t serial = 0;
-						// use same code to determine device's serial number as in airspy_list_devices()
-						{
-							char *start, *end;
+		invoke_callback(device, &transfer);
+	}
 
-							serial_number[SERIAL_AIRSPY_EXPECTED_SIZE] = 0;
-							start = (char*)(serial_number + STR_PREFIX_SERIAL_AIRSPY_SIZE);
-							end = NULL;
-							serial = strtoull(start, &end, 16);
-						}
+	elapsed_us = (uint32_t) (get_time_us() - start_us);
+	device->latency.callback_us = elapsed_us;
+	if (elapsed_us > device->latency.callback_max_us)
+	{
+		device->latency.callback_max_us = elapsed_us;
+	}
+}
 
-						if (serial == serial_number_val)
-						{
-#ifdef __linux__
-							/* Check whether a kernel driver is attached to interface #0. If so, we'll
-							* need to detach it.
-							*/
-							if (libusb_kernel_driver_active(dev_handle, 0))
-							{
-								libusb_detach_kernel_driver(dev_handle, 0);
-							}
-#endif
-							result = libusb_set_configuration(dev_handle, 1);
-							if (result != 0)
-							{
-								libusb_close(dev_handle);
-								*libusb_dev_handle = NULL;
-								continue;
-							}
-							result = libusb_claim_interface(dev_handle, 0);
-							if (result != 0)
-							{
-								libusb_close(dev_handle);
-								*libusb_dev_handle = NULL;
-								continue;
-							}
-							break;
-						}
-						else
-						{
-							libusb_close(dev_handle);
-							*libusb_dev_handle = NULL;
-							continue;
-						}
-					}
-					else
-					{
-						libusb_close(dev_handle);
-						*libusb_dev_handle = NULL;
-						continue;
-					}
-				}
-			}
-			else
-			{
-				if (libusb_open(dev, libusb_dev_handle) == 0)
-				{
-					dev_handle = *libusb_dev_handle;
-#ifdef __linux__
-					/* Check whether a kernel driver is attached to interface #0. If so, we'll
-					* need to detach it.
-					*/
-					if (libusb_kernel_driver_active(dev_handle, 0))
-					{
-						libusb_detach_kernel_driver(dev_handle, 0);
-					}
-#endif
-					result = libusb_set_configuration(dev_handle, 1);
-					if (result != 0)
-					{
-						libusb_close(dev_handle);
-						*libusb_dev_handle = NULL;
-						continue;
-					}
-					result = libusb_claim_interface(dev_handle, 0);
-					if (result != 0)
-					{
-						libusb_close(dev_handle);
-						*libusb_dev_handle = NULL;
-						continue;
-					}
-					break;
-				}
-			}
-		}
-	}
-	libusb_free_device_list(devices, 1);
+static void* consumer_threadproc(void *arg)
+{
+	uint16_t* input_samples;
+	uint32_t dropped_buffers;
+	uint64_t timestamp;
+	airspy_device_t* device = (airspy_device_t*)arg;
 
-	dev_handle = device->usb_device;
-	if (dev_handle == NULL)
+	thread_sched_apply(&device->thread_sched[AIRSPY_THREAD_CONSUMER]);
+
+	while (device->streaming && !device->stop_requested)
 	{
-		*ret = AIRSPY_ERROR_NOT_FOUND;
-		return;
+		input_samples = (uint16_t *) buffer_ring_acquire(&device->received_samples, &dropped_buffers, &timestamp, BUFFER_RING_INFINITE);
+		if (input_samples == NULL || !device->streaming || device->stop_requested)
+		{
+			break;
+		}
+
+		process_buffer(device, input_samples, dropped_buffers, timestamp);
+
+		buffer_ring_release(&device->received_samples);
 	}
 
-	*ret = AIRSPY_SUCCESS;
-	return;
+	pthread_exit(NULL);
+
+	return NULL;
 }
 
-static void airspy_open_device_fd(airspy_device_t* device,
-	int* ret,
-	int fd)
+// The transfer is no longer in flight
+static void retire_transfer(airspy_device_t* device)
 {
-	int result = -1;
+	if (ATOMIC_DEC(&device->transfers_active) == 0 && device->context != NULL)
+	{
+		pthread_mutex_lock(&device->context->mp);
+		pthread_cond_broadcast(&device->context->idle_cv);
+		pthread_mutex_unlock(&device->context->mp);
+	}
+}
 
-#ifdef __ANDROID__
-	result = libusb_wrap_sys_device(device->usb_context, (intptr_t)fd, &device->usb_device);
-#else
-	device->usb_device = NULL;
-	*ret = AIRSPY_ERROR_UNSUPPORTED;
-	return;
-#endif
+static void airspy_libusb_transfer_callback(struct libusb_transfer* usb_transfer)
+{
+	airspy_device_t* device = (airspy_device_t*)usb_transfer->user_data;
+	uint64_t now_us;
+	uint32_t depth;
+	int status;
 
-	if (result != 0 || device->usb_device == NULL)
+	if (!device->streaming || device->stop_requested)
 	{
-		*ret = AIRSPY_ERROR_LIBUSB;
+		retire_transfer(device);
 		return;
 	}
 
-#ifdef __linux__
-	/* Check whether a kernel driver is attached to interface #0. If so, we'll
-	* need to detach it.
-	*/
-	if (libusb_kernel_driver_active(device->usb_device, 0))
+	if (usb_transfer->status == LIBUSB_TRANSFER_COMPLETED && usb_transfer->actual_length == usb_transfer->length)
 	{
-		libusb_detach_kernel_driver(device->usb_device, 0);
-	}
-#endif
+		// Transfers complete back to back, so the interval between two of them is the time to fill one
+		now_us = get_time_us();
+		if (device->last_completion_us != 0)
+		{
+			device->latency.transfer_us = (uint32_t) ((device->latency.transfer_us * 7 + (now_us - device->last_completion_us)) / 8);
+			histogram_add(&device->histograms[AIRSPY_HISTOGRAM_USB_INTERVAL], now_us - device->last_completion_us);
+		}
+		device->last_completion_us = now_us;
 
-	result = libusb_set_configuration(device->usb_device, 1);
-	if (result != 0)
+		if (device->watchdog != NULL)
+		{
+			check_watchdog(device, now_us);
+		}
+
+		STAT_ADD(&device->stats.bytes, usb_transfer->actual_length);
+		STAT_ADD(&device->stats.buffers, 1);
+
+		// Swaps the transfer buffer with a free one, or counts a drop when the consumer is behind
+		if (device->inline_conversion && device->callback != NULL)
+		{
+			// Runs before the resubmission, the other transfers in flight cover the processing time
+			process_buffer(device, (uint16_t *) usb_transfer->buffer, 0, now_us);
+			if (device->stop_requested)
+			{
+				retire_transfer(device);
+				return;
+			}
+		}
+		else if (buffer_ring_push(&device->received_samples, (void **) &usb_transfer->buffer, now_us))
+		{
+			depth = buffer_ring_depth(&device->received_samples);
+			if (depth > device->stats.queue_high_water)
+			{
+				STAT_STORE(&device->stats.queue_high_water, depth);
+			}
+			histogram_add(&device->histograms[AIRSPY_HISTOGRAM_QUEUE_DEPTH], depth);
+
+			if (device->event_loop)
+			{
+				signal_event_fd(device);
+			}
+			else if (uses_dispatch(device))
+			{
+				dsp_pool_schedule(&device->dsp_task);
+			}
+		}
+		else
+		{
+			STAT_ADD(&device->stats.queue_overruns, 1);
+			histogram_add(&device->histograms[AIRSPY_HISTOGRAM_QUEUE_DEPTH], buffer_ring_depth(&device->received_samples));
+		}
+
+		if (libusb_submit_transfer(usb_transfer) != 0)
+		{
+			STAT_ADD(&device->stats.resubmit_failures, 1);
+			device->stop_requested = true;
+			retire_transfer(device);
+		}
+	}
+	else
 	{
-		libusb_close(device->usb_device);
-		device->usb_device = NULL;
-		*ret = AIRSPY_ERROR_LIBUSB;
-		return;
+		status = usb_transfer->status == LIBUSB_TRANSFER_COMPLETED ? AIRSPY_TRANSFER_SHORT : (int) usb_transfer->status;
+		if (status >= 0 && status < AIRSPY_TRANSFER_ERROR_END)
+		{
+			STAT_ADD(&device->stats.transfer_errors[status], 1);
+		}
+
+		device->stop_requested = true;
+		retire_transfer(device);
 	}
+}
 
-	result = libusb_claim_interface(device->usb_device, 0);
-	if (result != 0)
+static void* transfer_threadproc(void* arg)
+{
+	airspy_device_t* device = (airspy_device_t*)arg;
+	int error;
+	struct timeval timeout = { 0, 500000 };
+
+	thread_sched_apply(&device->thread_sched[AIRSPY_THREAD_TRANSFER]);
+
+	while (device->streaming && !device->stop_requested)
 	{
-		libusb_close(device->usb_device);
-		device->usb_device = NULL;
-		*ret = AIRSPY_ERROR_LIBUSB;
-		return;
+		error = libusb_handle_events_timeout_completed(device->usb_context, &timeout, NULL);
+		if (error < 0)
+		{
+			if (error != LIBUSB_ERROR_INTERRUPTED)
+				device->stop_requested = true;
+		}
 	}
 
-	*ret = AIRSPY_SUCCESS;
-	return;
+	pthread_exit(NULL);
+
+	return NULL;
 }
 
-static int airspy_read_samplerates_from_fw(struct airspy_device* device, uint32_t* buffer, const uint32_t len)
+static void* context_event_threadproc(void* arg)
 {
-	int result;
+	airspy_context_t* context = (airspy_context_t*)arg;
+	struct timeval timeout = { 0, 500000 };
 
-	result = libusb_control_transfer(
-		device->usb_device,
-		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-		AIRSPY_GET_SAMPLERATES,
-		0,
-		len,
-		(unsigned char*)buffer,
-		(len > 0 ? len : 1) * sizeof(uint32_t),
-		0);
+#ifdef _WIN32
 
-	if (result < 1)
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+#endif
+
+	// Errors are reported through the transfers of each device
+	while (!context->stop)
 	{
-		return AIRSPY_ERROR_OTHER;
+		libusb_handle_events_timeout_completed(context->usb_context, &timeout, NULL);
 	}
 
-	return AIRSPY_SUCCESS;
+	pthread_exit(NULL);
+
+	return NULL;
 }
 
-static int airspy_open_init(airspy_device_t** device, uint64_t serial_number, int fd)
+// Runs on the DSP pool, never on two workers at once
+static int dsp_task_threadproc(void* arg)
 {
-	airspy_device_t* lib_device;
-	int libusb_error;
-	int result;
-
-	*device = NULL;
+	int i;
+	uint16_t* input_samples;
+	uint32_t dropped_buffers;
+	uint64_t timestamp;
+	airspy_device_t* device = (airspy_device_t*)arg;
 
-	lib_device = (airspy_device_t*)calloc(1, sizeof(airspy_device_t));
-	if (lib_device == NULL)
+	for (i = 0; i < DISPATCH_BATCH && !device->stop_requested; i++)
 	{
-		return AIRSPY_ERROR_NO_MEM;
+		input_samples = (uint16_t *) buffer_ring_acquire(&device->received_samples, &dropped_buffers, &timestamp, 0);
+		if (input_samples == NULL)
+		{
+			return 0;
+		}
+
+		process_buffer(device, input_samples, dropped_buffers, timestamp);
+
+		buffer_ring_release(&device->received_samples);
 	}
 
-#ifdef __ANDROID__
-	// LibUSB does not support device discovery on android
-	libusb_set_option(NULL, LIBUSB_OPTION_NO_DEVICE_DISCOVERY, NULL);
-#endif
+	return !device->stop_requested && buffer_ring_pending(&device->received_samples);
+}
 
-	libusb_error = libusb_init(&lib_device->usb_context);
-	if (libusb_error != 0)
+// Once stop_requested is set, the transfers of a context device get reaped by its event thread
+static void wait_context_transfers(airspy_device_t* device)
+{
+	airspy_context_t* context = device->context;
+
+	pthread_mutex_lock(&context->mp);
+	while (ATOMIC_LOAD(&device->transfers_active) > 0)
 	{
-		free(lib_device);
-		return AIRSPY_ERROR_LIBUSB;
+		pthread_cond_wait(&context->idle_cv, &context->mp);
 	}
+	pthread_mutex_unlock(&context->mp);
+}
 
-	if (fd == FILE_DESCRIPTOR_UNUSED) {
-		airspy_open_device(lib_device,
-			&result,
-			airspy_usb_vid,
-			airspy_usb_pid,
-			serial_number);
+static void kill_conversion_threads(airspy_device_t* device)
+{
+	uint32_t i;
+	conversion_worker_t* worker;
+
+	pthread_mutex_lock(&device->conversion_mp);
+	device->conversion_stop = true;
+	pthread_cond_broadcast(&device->conversion_cv);
+	pthread_mutex_unlock(&device->conversion_mp);
+
+	for (i = 0; i < device->conversion_threads; i++)
+	{
+		worker = &device->conversion_workers[i];
+
+		if (i > 0 && worker->device != NULL)
+		{
+			pthread_join(worker->thread, NULL);
+		}
+		if (worker->cnv_f != NULL)
+		{
+			iqconverter_float_free(worker->cnv_f);
+			worker->cnv_f = NULL;
+		}
+		if (worker->cnv_i != NULL)
+		{
+			iqconverter_int16_free(worker->cnv_i);
+			worker->cnv_i = NULL;
+		}
+		worker->device = NULL;
 	}
-	else {
-		airspy_open_device_fd(lib_device,
+}
+
+// Worker 0 is the consumer thread itself
+static int create_conversion_threads(airspy_device_t* device, pthread_attr_t* attr)
+{
+	uint32_t i;
+	conversion_worker_t* worker;
+
+	device->conversion_stop = false;
+	device->conversion_generation = 0;
+	device->conversion_chunks = 1;
+
+	for (i = 0; i < device->conversion_threads; i++)
+	{
+		worker = &device->conversion_workers[i];
+		worker->index = i;
+		worker->cnv_f = iqconverter_float_clone(device->cnv_f);
+		worker->cnv_i = iqconverter_int16_clone(device->cnv_i);
+		worker->device = device;
+
+		if (i > 0 && pthread_create(&worker->thread, attr, conversion_threadproc, worker) != 0)
+		{
+			worker->device = NULL;
+			return AIRSPY_ERROR_THREAD;
+		}
+	}
+
+	return AIRSPY_SUCCESS;
+}
+
+static bool needs_consumer_thread(const airspy_device_t* device)
+{
+	return device->callback != NULL && !device->event_loop && !device->inline_conversion && !uses_dispatch(device);
+}
+
+static int kill_io_threads(airspy_device_t* device)
+{
+	struct timeval timeout = { 0, 0 };
+
+	if (device->streaming)
+	{
+		device->stop_requested = true;
+		cancel_transfers(device);
+
+		buffer_ring_close(&device->received_samples);
+
+		pthread_mutex_lock(&device->pool_mp);
+		pthread_cond_broadcast(&device->pool_cv);
+		pthread_mutex_unlock(&device->pool_mp);
+
+		// No more buffer gets dispatched past this point
+		if (device->context != NULL)
+		{
+			wait_context_transfers(device);
+		}
+		else if (!device->event_loop)
+		{
+			pthread_join(device->transfer_thread, NULL);
+		}
+		if (needs_consumer_thread(device))
+		{
+			pthread_join(device->consumer_thread, NULL);
+		}
+		if (uses_dispatch(device))
+		{
+			dsp_pool_wait_idle(&device->dsp_task);
+			dsp_pool_detach(&device->dsp_task);
+		}
+		clear_event_fd(device);
+
+		if (device->conversion_threads > 1)
+		{
+			kill_conversion_threads(device);
+		}
+
+		if (device->context == NULL)
+		{
+			libusb_handle_events_timeout_completed(device->usb_context, &timeout, NULL);
+		}
+
+		device->stop_requested = false;
+		device->streaming = false;
+	}
+
+	return AIRSPY_SUCCESS;
+}
+
+/*
+ * Undoes a create_io_threads() that failed before any transfer was
+ * submitted, the threads that were started see the stop and exit.
+ */
+static void abort_io_threads(airspy_device_t* device, bool attached, bool consumer_started)
+{
+	device->stop_requested = true;
+	buffer_ring_close(&device->received_samples);
+
+	if (consumer_started)
+	{
+		pthread_join(device->consumer_thread, NULL);
+	}
+	if (attached)
+	{
+		dsp_pool_detach(&device->dsp_task);
+	}
+	if (device->conversion_threads > 1)
+	{
+		kill_conversion_threads(device);
+	}
+
+	device->callback = NULL;
+	device->stop_requested = false;
+	device->streaming = false;
+}
+
+static int create_io_threads(airspy_device_t* device, airspy_sample_block_cb_fn callback)
+{
+	int i;
+	int result;
+	pthread_attr_t attr;
+
+	if (!device->streaming && !device->stop_requested)
+	{
+		device->callback = callback;
+		device->streaming = true;
+		device->transfers_active = 0;
+
+		buffer_ring_reset(&device->received_samples, device->wait_strategy, get_queue_limit(device));
+
+		memset(&device->latency, 0, sizeof(airspy_latency_t));
+		for (i = 0; i < AIRSPY_STAGE_END; i++)
+		{
+			histogram_reset(&device->stage_times[i]);
+		}
+		for (i = 0; i < AIRSPY_HISTOGRAM_END; i++)
+		{
+			histogram_reset(&device->histograms[i]);
+		}
+		device->callback_start_us = 0;
+		device->watchdog_start_us = 0;
+		device->last_completion_us = 0;
+
+		device->block_start = 0;
+		device->block_fill = 0;
+		device->block_dropped = 0;
+		device->pool_dropped = 0;
+		device->block_sample_type = device->sample_type;
+
+		device->pull_acquired = false;
+		device->pull_offset = 0;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+		if (device->conversion_threads > 1)
+		{
+			result = create_conversion_threads(device, &attr);
+			if (result != AIRSPY_SUCCESS)
+			{
+				pthread_attr_destroy(&attr);
+				abort_io_threads(device, false, false);
+				return result;
+			}
+		}
+
+		if (uses_dispatch(device) && dsp_pool_attach(&device->dsp_task) != 0)
+		{
+			pthread_attr_destroy(&attr);
+			abort_io_threads(device, false, false);
+			return AIRSPY_ERROR_THREAD;
+		}
+
+		// Pull mode, the event loop, inline conversion and the DSP pool all do without the consumer thread
+		if (needs_consumer_thread(device))
+		{
+			result = pthread_create(&device->consumer_thread, &attr, consumer_threadproc, device);
+			if (result != 0)
+			{
+				pthread_attr_destroy(&attr);
+				abort_io_threads(device, uses_dispatch(device), false);
+				return AIRSPY_ERROR_THREAD;
+			}
+		}
+
+		// The event loop drives the USB side from airspy_process_events(), a context from its event thread
+		if (!device->event_loop && device->context == NULL)
+		{
+			result = pthread_create(&device->transfer_thread, &attr, transfer_threadproc, device);
+			if (result != 0)
+			{
+				pthread_attr_destroy(&attr);
+				abort_io_threads(device, uses_dispatch(device), needs_consumer_thread(device));
+				return AIRSPY_ERROR_THREAD;
+			}
+		}
+
+		pthread_attr_destroy(&attr);
+
+		// Last, a context may complete transfers on its event thread right away
+		result = prepare_transfers(device, LIBUSB_ENDPOINT_IN | 1, (libusb_transfer_cb_fn)airspy_libusb_transfer_callback);
+		if (result != AIRSPY_SUCCESS)
+		{
+			// Everything is running, stop it like airspy_stop_rx() and take back the transfers already submitted
+			kill_io_threads(device);
+			device->callback = NULL;
+			return result;
+		}
+	}
+	else {
+		return AIRSPY_ERROR_BUSY;
+	}
+
+	return AIRSPY_SUCCESS;
+}
+
+static void airspy_open_exit(airspy_device_t* device)
+{
+	if (device->usb_device != NULL)
+	{
+		libusb_release_interface(device->usb_device, 0);
+		libusb_close(device->usb_device);
+		device->usb_device = NULL;
+	}
+	if (device->context != NULL)
+	{
+		pthread_mutex_lock(&device->context->mp);
+		device->context->device_count--;
+		pthread_mutex_unlock(&device->context->mp);
+	}
+	else
+	{
+		libusb_exit(device->usb_context);
+	}
+	device->usb_context = NULL;
+}
+
+static void airspy_open_device(airspy_device_t* device,
+	int* ret,
+	uint16_t vid,
+	uint16_t pid,
+	uint64_t serial_number_val)
+{
+	int i;
+	int result;
+	libusb_device_handle** libusb_dev_handle;
+	int serial_number_len;
+	libusb_device_handle* dev_handle;
+	libusb_device *dev;
+	libusb_device** devices = NULL;
+
+	ssize_t cnt;
+	int serial_descriptor_index;
+	struct libusb_device_descriptor device_descriptor;
+	unsigned char serial_number[SERIAL_AIRSPY_EXPECTED_SIZE + 1];
+
+	libusb_dev_handle = &device->usb_device;
+	*libusb_dev_handle = NULL;
+
+	cnt = libusb_get_device_list(device->usb_context, &devices);
+	if (cnt < 0)
+	{
+		*ret = AIRSPY_ERROR_NOT_FOUND;
+		return;
+	}
+
+	i = 0;
+	while ((dev = devices[i++]) != NULL)
+	{
+		libusb_get_device_descriptor(dev, &device_descriptor);
+
+		if ((device_descriptor.idVendor == vid) &&
+			(device_descriptor.idProduct == pid))
+		{
+			if (serial_number_val != SERIAL_NUMBER_UNUSED)
+			{
+				serial_descriptor_index = device_descriptor.iSerialNumber;
+				if (serial_descriptor_index > 0)
+				{
+					if (libusb_open(dev, libusb_dev_handle) != 0)
+					{
+						*libusb_dev_handle = NULL;
+						continue;
+					}
+					dev_handle = *libusb_dev_handle;
+					serial_number_len = libusb_get_string_descriptor_ascii(dev_handle,
+						serial_descriptor_index,
+						serial_number,
+						sizeof(serial_number));
+					if (serial_number_len == SERIAL_AIRSPY_EXPECTED_SIZE)
+					{
+						uint64_t serial = 0;
+						// use same code to determine device's serial number as in airspy_list_devices()
+						{
+							char *start, *end;
+
+							serial_number[SERIAL_AIRSPY_EXPECTED_SIZE] = 0;
+							start = (char*)(serial_number + STR_PREFIX_SERIAL_AIRSPY_SIZE);
+							end = NULL;
+							serial = strtoull(start, &end, 16);
+						}
+
+						if (serial == serial_number_val)
+						{
+#ifdef __linux__
+							/* Check whether a kernel driver is attached to interface #0. If so, we'll
+							* need to detach it.
+							*/
+							if (libusb_kernel_driver_active(dev_handle, 0))
+							{
+								libusb_detach_kernel_driver(dev_handle, 0);
+							}
+#endif
+							result = libusb_set_configuration(dev_handle, 1);
+							if (result != 0)
+							{
+								libusb_close(dev_handle);
+								*libusb_dev_handle = NULL;
+								continue;
+							}
+							result = libusb_claim_interface(dev_handle, 0);
+							if (result != 0)
+							{
+								libusb_close(dev_handle);
+								*libusb_dev_handle = NULL;
+								continue;
+							}
+							break;
+						}
+						else
+						{
+							libusb_close(dev_handle);
+							*libusb_dev_handle = NULL;
+							continue;
+						}
+					}
+					else
+					{
+						libusb_close(dev_handle);
+						*libusb_dev_handle = NULL;
+						continue;
+					}
+				}
+			}
+			else
+			{
+				if (libusb_open(dev, libusb_dev_handle) == 0)
+				{
+					dev_handle = *libusb_dev_handle;
+#ifdef __linux__
+					/* Check whether a kernel driver is attached to interface #0. If so, we'll
+					* need to detach it.
+					*/
+					if (libusb_kernel_driver_active(dev_handle, 0))
+					{
+						libusb_detach_kernel_driver(dev_handle, 0);
+					}
+#endif
+					result = libusb_set_configuration(dev_handle, 1);
+					if (result != 0)
+					{
+						libusb_close(dev_handle);
+						*libusb_dev_handle = NULL;
+						continue;
+					}
+					result = libusb_claim_interface(dev_handle, 0);
+					if (result != 0)
+					{
+						libusb_close(dev_handle);
+						*libusb_dev_handle = NULL;
+						continue;
+					}
+					break;
+				}
+			}
+		}
+	}
+	libusb_free_device_list(devices, 1);
+
+	dev_handle = device->usb_device;
+	if (dev_handle == NULL)
+	{
+		*ret = AIRSPY_ERROR_NOT_FOUND;
+		return;
+	}
+
+	*ret = AIRSPY_SUCCESS;
+	return;
+}
+
+static void airspy_open_device_fd(airspy_device_t* device,
+	int* ret,
+	int fd)
+{
+	int result = -1;
+
+#ifdef __ANDROID__
+	result = libusb_wrap_sys_device(device->usb_context, (intptr_t)fd, &device->usb_device);
+#else
+	device->usb_device = NULL;
+	*ret = AIRSPY_ERROR_UNSUPPORTED;
+	return;
+#endif
+
+	if (result != 0 || device->usb_device == NULL)
+	{
+		*ret = AIRSPY_ERROR_LIBUSB;
+		return;
+	}
+
+#ifdef __linux__
+	/* Check whether a kernel driver is attached to interface #0. If so, we'll
+	* need to detach it.
+	*/
+	if (libusb_kernel_driver_active(device->usb_device, 0))
+	{
+		libusb_detach_kernel_driver(device->usb_device, 0);
+	}
+#endif
+
+	result = libusb_set_configuration(device->usb_device, 1);
+	if (result != 0)
+	{
+		libusb_close(device->usb_device);
+		device->usb_device = NULL;
+		*ret = AIRSPY_ERROR_LIBUSB;
+		return;
+	}
+
+	result = libusb_claim_interface(device->usb_device, 0);
+	if (result != 0)
+	{
+		libusb_close(device->usb_device);
+		device->usb_device = NULL;
+		*ret = AIRSPY_ERROR_LIBUSB;
+		return;
+	}
+
+	*ret = AIRSPY_SUCCESS;
+	return;
+}
+
+static int airspy_read_samplerates_from_fw(struct airspy_device* device, uint32_t* buffer, const uint32_t len)
+{
+	int result;
+
+	result = libusb_control_transfer(
+		device->usb_device,
+		LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+		AIRSPY_GET_SAMPLERATES,
+		0,
+		len,
+		(unsigned char*)buffer,
+		(len > 0 ? len : 1) * sizeof(uint32_t),
+		0);
+
+	if (result < 1)
+	{
+		return AIRSPY_ERROR_OTHER;
+	}
+
+	return AIRSPY_SUCCESS;
+}
+
+static pthread_once_t dsp_init_once = PTHREAD_ONCE_INIT;
+
+static void dsp_bind_kernels(void)
+{
+	uint32_t cpu_features;
+
+	cpu_features = cpu_features_detect();
+
+	sample_converter_init(cpu_features);
+	iqconverter_float_init(cpu_features);
+	iqconverter_int16_init(cpu_features);
+}
+
+// Kernels are bound once, the tables are then read by the conversion threads of every open device
+static void dsp_init(void)
+{
+	pthread_once(&dsp_init_once, dsp_bind_kernels);
+}
+
+static int airspy_open_init(airspy_device_t** device, airspy_context_t* context, uint64_t serial_number, int fd)
+{
+	airspy_device_t* lib_device;
+	int libusb_error;
+	int result;
+
+	*device = NULL;
+
+	lib_device = (airspy_device_t*)calloc(1, sizeof(airspy_device_t));
+	if (lib_device == NULL)
+	{
+		return AIRSPY_ERROR_NO_MEM;
+	}
+
+	dsp_init();
+
+#ifdef __ANDROID__
+	// LibUSB does not support device discovery on android
+	libusb_set_option(NULL, LIBUSB_OPTION_NO_DEVICE_DISCOVERY, NULL);
+#endif
+
+	if (context != NULL)
+	{
+		pthread_mutex_lock(&context->mp);
+		context->device_count++;
+		pthread_mutex_unlock(&context->mp);
+
+		lib_device->context = context;
+		lib_device->usb_context = context->usb_context;
+	}
+	else
+	{
+		libusb_error = libusb_init(&lib_device->usb_context);
+		if (libusb_error != 0)
+		{
+			free(lib_device);
+			return AIRSPY_ERROR_LIBUSB;
+		}
+	}
+
+	if (fd == FILE_DESCRIPTOR_UNUSED) {
+		airspy_open_device(lib_device,
+			&result,
+			airspy_usb_vid,
+			airspy_usb_pid,
+			serial_number);
+	}
+	else {
+		airspy_open_device_fd(lib_device,
 			&result,
 			fd);
 	}
 
-	if (lib_device->usb_device == NULL)
+	if (lib_device->usb_device == NULL)
+	{
+		airspy_open_exit(lib_device);
+		free(lib_device);
+		return result;
+	}
+
+	lib_device->transfers = NULL;
+	lib_device->callback = NULL;
+	lib_device->transfer_count = DEFAULT_TRANSFER_COUNT;
+	lib_device->transfer_size = 0;
+	lib_device->buffer_size = DEFAULT_TRANSFER_SIZE;
+	lib_device->queue_depth = RAW_BUFFER_COUNT;
+	lib_device->buffer_auto_tune = false;
+	lib_device->block_size = 0;
+	lib_device->pool_count = 1;
+	lib_device->pool_memory = NULL;
+	lib_device->pool_memory_size = 0;
+	lib_device->pool_base = NULL;
+	lib_device->pool_refs = NULL;
+	lib_device->memory_flags = 0;
+	lib_device->numa_node = ARENA_ANY_NODE;
+	pthread_mutex_init(&lib_device->pool_mp, NULL);
+	pthread_cond_init(&lib_device->pool_cv, NULL);
+	dsp_task_init(&lib_device->dsp_task, dsp_task_threadproc, lib_device);
+	lib_device->shared_dsp = false;
+	lib_device->event_loop = false;
+	lib_device->inline_conversion = false;
+	lib_device->event_signalled = false;
+	lib_device->event_fds[0] = FILE_DESCRIPTOR_UNUSED;
+	lib_device->event_fds[1] = FILE_DESCRIPTOR_UNUSED;
+	lib_device->packing_enabled = false;
+	lib_device->streaming = false;
+	lib_device->stop_requested = false;
+	lib_device->sample_type = AIRSPY_SAMPLE_FLOAT32_IQ;
+	lib_device->conversion_threads = 1;
+	lib_device->wait_strategy = AIRSPY_WAIT_BLOCK;
+
+	result = airspy_read_samplerates_from_fw(lib_device, &lib_device->supported_samplerate_count, 0);
+	if (result == AIRSPY_SUCCESS)
+	{
+		lib_device->supported_samplerates = (uint32_t *) malloc(lib_device->supported_samplerate_count * sizeof(uint32_t));
+		result = airspy_read_samplerates_from_fw(lib_device, lib_device->supported_samplerates, lib_device->supported_samplerate_count);
+		if (result != AIRSPY_SUCCESS)
+		{
+			free(lib_device->supported_samplerates);
+		}
+	}
+
+	if (result != AIRSPY_SUCCESS)
+	{
+		lib_device->supported_samplerate_count = 2;
+		lib_device->supported_samplerates = (uint32_t *) malloc(lib_device->supported_samplerate_count * sizeof(uint32_t));
+		lib_device->supported_samplerates[0] = 10000000;
+		lib_device->supported_samplerates[1] = 2500000;
+	}
+
+	airspy_set_packing(lib_device, 0);
+
+	result = allocate_transfers(lib_device);
+	if (result != 0)
+	{
+		airspy_open_exit(lib_device);
+		free(lib_device->supported_samplerates);
+		free(lib_device);
+		return AIRSPY_ERROR_NO_MEM;
+	}
+
+	lib_device->cnv_f = iqconverter_float_create(HB_KERNEL_FLOAT, HB_KERNEL_FLOAT_LEN);
+	lib_device->cnv_i = iqconverter_int16_create(HB_KERNEL_INT16, HB_KERNEL_INT16_LEN);
+
+	pthread_cond_init(&lib_device->conversion_cv, NULL);
+	pthread_cond_init(&lib_device->conversion_done_cv, NULL);
+	pthread_mutex_init(&lib_device->conversion_mp, NULL);
+
+	*device = lib_device;
+
+	return AIRSPY_SUCCESS;
+}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	void ADDCALL airspy_lib_version(airspy_lib_version_t* lib_version)
+	{
+		lib_version->major_version = AIRSPY_VER_MAJOR;
+		lib_version->minor_version = AIRSPY_VER_MINOR;
+		lib_version->revision = AIRSPY_VER_REVISION;
+	}
+
+	/* airspy_init() deprecated */
+	int ADDCALL airspy_init(void)
+	{
+		return AIRSPY_SUCCESS;
+	}
+
+	/* airspy_exit() deprecated */
+	int ADDCALL airspy_exit(void)
+	{
+		return AIRSPY_SUCCESS;
+	}
+
+int airspy_list_devices(uint64_t *serials, int count)
+{
+	libusb_device_handle* libusb_dev_handle;
+	struct libusb_context *context;
+	libusb_device** devices = NULL;
+	libusb_device *dev;
+	struct libusb_device_descriptor device_descriptor;
+
+	int serial_descriptor_index;
+	int serial_number_len;
+	int output_count;
+	int i;
+	unsigned char serial_number[SERIAL_AIRSPY_EXPECTED_SIZE + 1];
+
+	if (serials)
+	{
+		memset(serials, 0, sizeof(uint64_t) * count);
+	}
+
+#ifdef __ANDROID__
+	// LibUSB does not support device discovery on android
+	libusb_set_option(NULL, LIBUSB_OPTION_NO_DEVICE_DISCOVERY, NULL);
+#endif
+
+	if (libusb_init(&context) != 0)
+	{
+		return AIRSPY_ERROR_LIBUSB;
+	}
+
+	if (libusb_get_device_list(context, &devices) < 0)
+	{
+		return AIRSPY_ERROR_NOT_FOUND;
+	}
+
+	i = 0;
+	output_count = 0;
+	while ((dev = devices[i++]) != NULL && (!serials || output_count < count))
+	{
+		libusb_get_device_descriptor(dev, &device_descriptor);
+
+		if ((device_descriptor.idVendor == airspy_usb_vid) &&
+			(device_descriptor.idProduct == airspy_usb_pid))
+		{
+			serial_descriptor_index = device_descriptor.iSerialNumber;
+			if (serial_descriptor_index > 0)
+			{
+				if (libusb_open(dev, &libusb_dev_handle) != 0)
+				{
+					continue;
+				}
+
+				serial_number_len = libusb_get_string_descriptor_ascii(libusb_dev_handle,
+					serial_descriptor_index,
+					serial_number,
+					sizeof(serial_number));
+
+				if (serial_number_len == SERIAL_AIRSPY_EXPECTED_SIZE)
+				{
+					char *start, *end;
+					uint64_t serial;
+
+					serial_number[SERIAL_AIRSPY_EXPECTED_SIZE] = 0;
+					start = (char*)(serial_number + STR_PREFIX_SERIAL_AIRSPY_SIZE);
+					end = NULL;
+					serial = strtoull(start, &end, 16);
+					if (serial == 0 && start == end)
+					{
+						libusb_close(libusb_dev_handle);
+						continue;
+					}
+
+					if (serials)
+					{
+						serials[output_count] = serial;
+					}
+					output_count++;
+				}
+
+				libusb_close(libusb_dev_handle);
+			}
+		}
+	}
+
+	libusb_free_device_list(devices, 1);
+	libusb_exit(context);
+	return output_count;
+}
+
+	int ADDCALL airspy_open_sn(airspy_device_t** device, uint64_t serial_number)
+	{
+		int result;
+
+		result = airspy_open_init(device, NULL, serial_number, FILE_DESCRIPTOR_UNUSED);
+		return result;
+	}
+
+	int ADDCALL airspy_open_fd(airspy_device_t** device, int fd)
+	{
+		int result;
+
+		result = airspy_open_init(device, NULL, SERIAL_NUMBER_UNUSED, fd);
+		return result;
+	}
+
+	int ADDCALL airspy_open(airspy_device_t** device)
+	{
+		int result;
+
+		result = airspy_open_init(device, NULL, SERIAL_NUMBER_UNUSED, FILE_DESCRIPTOR_UNUSED);
+		return result;
+	}
+
+	int ADDCALL airspy_context_create(airspy_context_t** context)
+	{
+		airspy_context_t* lib_context;
+
+		*context = NULL;
+
+		lib_context = (airspy_context_t*)calloc(1, sizeof(airspy_context_t));
+		if (lib_context == NULL)
+		{
+			return AIRSPY_ERROR_NO_MEM;
+		}
+
+		dsp_init();
+
+		if (libusb_init(&lib_context->usb_context) != 0)
+		{
+			free(lib_context);
+			return AIRSPY_ERROR_LIBUSB;
+		}
+
+		pthread_mutex_init(&lib_context->mp, NULL);
+		pthread_cond_init(&lib_context->idle_cv, NULL);
+
+		if (pthread_create(&lib_context->event_thread, NULL, context_event_threadproc, lib_context) != 0)
+		{
+			libusb_exit(lib_context->usb_context);
+			pthread_cond_destroy(&lib_context->idle_cv);
+			pthread_mutex_destroy(&lib_context->mp);
+			free(lib_context);
+			return AIRSPY_ERROR_THREAD;
+		}
+
+		*context = lib_context;
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_context_destroy(airspy_context_t* context)
+	{
+		if (context == NULL)
+		{
+			return AIRSPY_SUCCESS;
+		}
+
+		pthread_mutex_lock(&context->mp);
+		if (context->device_count > 0)
+		{
+			pthread_mutex_unlock(&context->mp);
+			return AIRSPY_ERROR_BUSY;
+		}
+		context->stop = true;
+		pthread_mutex_unlock(&context->mp);
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+		libusb_interrupt_event_handler(context->usb_context);
+#endif
+		pthread_join(context->event_thread, NULL);
+
+		libusb_exit(context->usb_context);
+
+		pthread_cond_destroy(&context->idle_cv);
+		pthread_mutex_destroy(&context->mp);
+		free(context);
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_dsp_pool(uint32_t thread_count, const int* cpus, uint32_t cpu_count, int priority)
+	{
+		if (priority < 0 || priority > 99)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		if (dsp_pool_configure(thread_count, cpus, cpu_count, priority) != 0)
+		{
+			return thread_count > DSP_POOL_MAX_THREADS || cpu_count > DSP_POOL_MAX_THREADS ? AIRSPY_ERROR_INVALID_PARAM : AIRSPY_ERROR_BUSY;
+		}
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_shared_dsp(airspy_device_t* device, uint8_t value)
+	{
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
+
+		device->shared_dsp = value ? true : false;
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_open_context(airspy_context_t* context, airspy_device_t** device, uint64_t serial_number)
+	{
+		return airspy_open_init(device, context, serial_number, FILE_DESCRIPTOR_UNUSED);
+	}
+
+	int ADDCALL airspy_close(airspy_device_t* device)
+	{
+		int result;
+
+		result = AIRSPY_SUCCESS;
+
+		if (device != NULL)
+		{
+			result = airspy_stop_rx(device);
+
+			iqconverter_float_free(device->cnv_f);
+			iqconverter_int16_free(device->cnv_i);
+
+			pthread_cond_destroy(&device->conversion_cv);
+			pthread_cond_destroy(&device->conversion_done_cv);
+			pthread_mutex_destroy(&device->conversion_mp);
+			pthread_cond_destroy(&device->pool_cv);
+			pthread_mutex_destroy(&device->pool_mp);
+			dsp_task_destroy(&device->dsp_task);
+
+			free_transfers(device);
+#ifndef _WIN32
+			close_event_fd(device);
+#endif
+			airspy_open_exit(device);
+			free(device->supported_samplerates);
+			free(device);
+		}
+
+		return result;
+	}
+
+	int ADDCALL airspy_get_samplerates(struct airspy_device* device, uint32_t* buffer, const uint32_t len)
+	{
+		uint32_t i;
+
+		if (len == 0)
+		{
+			*buffer = device->supported_samplerate_count;
+		}
+		else if (len <= device->supported_samplerate_count)
+		{
+			memcpy(buffer, device->supported_samplerates, len * sizeof(uint32_t));
+
+			if (!SAMPLE_TYPE_IS_IQ(device->sample_type))
+			{
+				for (i = 0; i < len; i++)
+				{
+					buffer[i] *= 2;
+				}
+			}
+		}
+		else
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_samplerate(airspy_device_t* device, uint32_t samplerate)
+	{
+		int result;
+		uint8_t retval;
+		uint8_t length;
+		uint32_t i;
+
+		if (samplerate >= MIN_SAMPLERATE_BY_VALUE)
+		{
+			for (i = 0; i < device->supported_samplerate_count; i++)
+			{
+				if (samplerate == device->supported_samplerates[i])
+				{
+					samplerate = i;
+					break;
+				}
+			}
+
+			if (samplerate >= MIN_SAMPLERATE_BY_VALUE)
+			{
+				if (SAMPLE_TYPE_IS_IQ(device->sample_type))
+				{
+					samplerate *= 2;
+				}
+				samplerate /= 1000;
+			}
+		}
+
+		libusb_clear_halt(device->usb_device, LIBUSB_ENDPOINT_IN | 1);
+
+		length = 1;
+
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SET_SAMPLERATE,
+			0,
+			samplerate,
+			&retval,
+			length,
+			0
+			);
+
+		if (result < length)
+		{
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
+		}
+	}
+
+	int ADDCALL airspy_set_receiver_mode(airspy_device_t* device, receiver_mode_t value)
+	{
+		int result;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_RECEIVER_MODE,
+			value,
+			0,
+			NULL,
+			0,
+			0
+			);
+
+		if (result != 0)
+		{
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
+		}
+	}
+
+	int ADDCALL airspy_start_rx(airspy_device_t* device, airspy_sample_block_cb_fn callback, void* ctx)
+	{
+		int result;
+
+		iqconverter_float_reset(device->cnv_f);
+		iqconverter_int16_reset(device->cnv_i);
+
+		result = airspy_set_receiver_mode(device, RECEIVER_MODE_OFF);
+		if (result != AIRSPY_SUCCESS)
+		{
+			return result;
+		}
+
+		libusb_clear_halt(device->usb_device, LIBUSB_ENDPOINT_IN | 1);
+
+		result = airspy_set_receiver_mode(device, RECEIVER_MODE_RX);
+		if (result == AIRSPY_SUCCESS)
+		{
+			device->ctx = ctx;
+			result = create_io_threads(device, callback);
+		}
+
+		return result;
+	}
+
+	int ADDCALL airspy_stop_rx(airspy_device_t* device)
+	{
+		int result1, result2;
+		result1 = kill_io_threads(device);
+
+		result2 = airspy_set_receiver_mode(device, RECEIVER_MODE_OFF);
+		if (result2 != AIRSPY_SUCCESS)
+		{
+			return result2;
+		}
+		return result1;
+	}
+
+	int ADDCALL airspy_acquire_block(airspy_device_t* device, airspy_transfer_t* transfer, int timeout_ms)
 	{
-		libusb_exit(lib_device->usb_context);
-		free(lib_device);
-		return result;
-	}
+		int result;
+		int sample_count;
+		uint16_t* input_samples;
+		uint32_t dropped_buffers;
+		uint64_t timestamp;
+		uint32_t elapsed_us;
+		enum airspy_sample_type sample_type;
 
-	lib_device->transfers = NULL;
-	lib_device->callback = NULL;
-	lib_device->transfer_count = 16;
-	lib_device->buffer_size = 262144;
-	lib_device->packing_enabled = false;
-	lib_device->streaming = false;
-	lib_device->stop_requested = false;
-	lib_device->sample_type = AIRSPY_SAMPLE_FLOAT32_IQ;
+		if (!device->streaming || device->stop_requested)
+		{
+			return AIRSPY_ERROR_STREAMING_STOPPED;
+		}
 
-	result = airspy_read_samplerates_from_fw(lib_device, &lib_device->supported_samplerate_count, 0);
-	if (result == AIRSPY_SUCCESS)
-	{
-		lib_device->supported_samplerates = (uint32_t *) malloc(lib_device->supported_samplerate_count * sizeof(uint32_t));
-		result = airspy_read_samplerates_from_fw(lib_device, lib_device->supported_samplerates, lib_device->supported_samplerate_count);
+		if (device->callback != NULL || device->pull_acquired)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
+
+		// Before taking a USB buffer, which stays queued while every pool buffer is retained
+		sample_type = device->sample_type;
+		result = prepare_output_buffer(device, get_output_sample_size(sample_type));
 		if (result != AIRSPY_SUCCESS)
 		{
-			free(lib_device->supported_samplerates);
+			return result;
+		}
+
+		input_samples = (uint16_t *) buffer_ring_acquire(&device->received_samples, &dropped_buffers, &timestamp, timeout_ms);
+		if (input_samples == NULL)
+		{
+			if (device->received_samples.closed)
+			{
+				return AIRSPY_ERROR_STREAMING_STOPPED;
+			}
+
+			if (device->event_loop)
+			{
+				clear_event_fd(device);
+			}
+			return AIRSPY_ERROR_TIMEOUT;
+		}
+
+		elapsed_us = (uint32_t) (get_time_us() - timestamp);
+		device->latency.queue_us = elapsed_us;
+		if (elapsed_us > device->latency.queue_max_us)
+		{
+			device->latency.queue_max_us = elapsed_us;
 		}
+		histogram_add(&device->histograms[AIRSPY_HISTOGRAM_QUEUE_WAIT], elapsed_us);
+
+		// Converted on the calling thread, straight out of the USB buffer
+		device->conversion_output = device->output_buffer;
+
+		transfer->samples = convert_buffer(device, sample_type, input_samples, &sample_count);
+		transfer->device = device;
+		transfer->ctx = device->ctx;
+		transfer->sample_count = sample_count;
+		transfer->sample_type = sample_type;
+		transfer->dropped_samples = (uint64_t) dropped_buffers * (uint64_t) sample_count;
+		STAT_ADD(&device->stats.samples, sample_count);
+
+		device->pull_acquired = true;
+
+		return AIRSPY_SUCCESS;
 	}
 
-	if (result != AIRSPY_SUCCESS)
+	int ADDCALL airspy_release_block(airspy_device_t* device)
 	{
-		lib_device->supported_samplerate_count = 2;
-		lib_device->supported_samplerates = (uint32_t *) malloc(lib_device->supported_samplerate_count * sizeof(uint32_t));
-		lib_device->supported_samplerates[0] = 10000000;
-		lib_device->supported_samplerates[1] = 2500000;
-	}
+		if (!device->pull_acquired)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
 
-	airspy_set_packing(lib_device, 0);
+		device->pull_acquired = false;
+		device->pull_offset = 0;
+		buffer_ring_release(&device->received_samples);
 
-	result = allocate_transfers(lib_device);
-	if (result != 0)
-	{
-		airspy_open_exit(lib_device);
-		free(lib_device->supported_samplerates);
-		free(lib_device);
-		return AIRSPY_ERROR_NO_MEM;
+		return AIRSPY_SUCCESS;
 	}
 
-	lib_device->cnv_f = iqconverter_float_create(HB_KERNEL_FLOAT, HB_KERNEL_FLOAT_LEN);
-	lib_device->cnv_i = iqconverter_int16_create(HB_KERNEL_INT16, HB_KERNEL_INT16_LEN);
+	int ADDCALL airspy_read_samples(airspy_device_t* device, void* buffer, uint32_t sample_count, int timeout_ms)
+	{
+		int result;
+		int wait_ms;
+		int sample_size;
+		uint32_t count;
+		uint32_t copied = 0;
+		uint64_t deadline_us = get_time_us() + (uint64_t) (timeout_ms > 0 ? timeout_ms : 0) * 1000;
+		uint64_t now_us;
 
-	pthread_cond_init(&lib_device->consumer_cv, NULL);
-	pthread_mutex_init(&lib_device->consumer_mp, NULL);
+		while (copied < sample_count)
+		{
+			if (!device->pull_acquired)
+			{
+				wait_ms = timeout_ms;
+				if (timeout_ms > 0)
+				{
+					now_us = get_time_us();
+					wait_ms = now_us < deadline_us ? (int) ((deadline_us - now_us + 999) / 1000) : 0;
+				}
 
-	*device = lib_device;
+				result = airspy_acquire_block(device, &device->pull_transfer, wait_ms);
+				if (result == AIRSPY_ERROR_TIMEOUT)
+				{
+					break;
+				}
+				else if (result != AIRSPY_SUCCESS)
+				{
+					return copied > 0 ? (int) copied : result;
+				}
+			}
 
-	return AIRSPY_SUCCESS;
-}
+			sample_size = get_output_sample_size(device->pull_transfer.sample_type);
+			count = device->pull_transfer.sample_count - device->pull_offset;
+			if (count > sample_count - copied)
+			{
+				count = sample_count - copied;
+			}
 
-#ifdef __cplusplus
-extern "C"
-{
-#endif
+			memcpy((uint8_t *) buffer + (size_t) copied * sample_size,
+				(uint8_t *) device->pull_transfer.samples + (size_t) device->pull_offset * sample_size,
+				(size_t) count * sample_size);
 
-	void ADDCALL airspy_lib_version(airspy_lib_version_t* lib_version)
-	{
-		lib_version->major_version = AIRSPY_VER_MAJOR;
-		lib_version->minor_version = AIRSPY_VER_MINOR;
-		lib_version->revision = AIRSPY_VER_REVISION;
+			copied += count;
+			device->pull_offset += count;
+			if (device->pull_offset == (uint32_t) device->pull_transfer.sample_count)
+			{
+				airspy_release_block(device);
+			}
+		}
+
+		return (int) copied;
 	}
 
-	/* airspy_init() deprecated */
-	int ADDCALL airspy_init(void)
+	int ADDCALL airspy_set_event_loop(airspy_device_t* device, uint8_t value)
 	{
+#ifdef _WIN32
+		(void) device;
+		return value ? AIRSPY_ERROR_UNSUPPORTED : AIRSPY_SUCCESS;
+#else
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
+
+		// A context has its own event thread
+		if (value && device->context != NULL)
+		{
+			return AIRSPY_ERROR_UNSUPPORTED;
+		}
+
+		if (value && !device->event_loop)
+		{
+			if (open_event_fd(device) != 0)
+			{
+				return AIRSPY_ERROR_OTHER;
+			}
+		}
+		else if (!value && device->event_loop)
+		{
+			close_event_fd(device);
+		}
+
+		device->event_loop = value ? true : false;
+		device->event_signalled = false;
+
 		return AIRSPY_SUCCESS;
+#endif
 	}
 
-	/* airspy_exit() deprecated */
-	int ADDCALL airspy_exit(void)
+	int ADDCALL airspy_set_inline_conversion(airspy_device_t* device, uint8_t value)
 	{
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
+
+		device->inline_conversion = value ? true : false;
+
 		return AIRSPY_SUCCESS;
 	}
 
-int airspy_list_devices(uint64_t *serials, int count)
-{
-	libusb_device_handle* libusb_dev_handle;
-	struct libusb_context *context;
-	libusb_device** devices = NULL;
-	libusb_device *dev;
-	struct libusb_device_descriptor device_descriptor;
+	int ADDCALL airspy_get_pollfds(airspy_device_t* device, airspy_pollfd_t* fds, uint32_t len, uint32_t* count)
+	{
+#ifdef _WIN32
+		(void) device;
+		(void) fds;
+		(void) len;
+		(void) count;
+		return AIRSPY_ERROR_UNSUPPORTED;
+#else
+		const struct libusb_pollfd** usb_fds;
+		uint32_t i;
 
-	int serial_descriptor_index;
-	int serial_number_len;
-	int output_count;
-	int i;
-	unsigned char serial_number[SERIAL_AIRSPY_EXPECTED_SIZE + 1];
+		if (!device->event_loop)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
 
-	if (serials)
-	{
-		memset(serials, 0, sizeof(uint64_t) * count);
-	}
+		usb_fds = libusb_get_pollfds(device->usb_context);
+		if (usb_fds == NULL)
+		{
+			return AIRSPY_ERROR_UNSUPPORTED;
+		}
 
-#ifdef __ANDROID__
-	// LibUSB does not support device discovery on android
-	libusb_set_option(NULL, LIBUSB_OPTION_NO_DEVICE_DISCOVERY, NULL);
-#endif
+		for (i = 0; usb_fds[i] != NULL; i++)
+		{
+			if (i < len)
+			{
+				fds[i].fd = usb_fds[i]->fd;
+				fds[i].events = usb_fds[i]->events;
+			}
+		}
+		libusb_free_pollfds(usb_fds);
 
-	if (libusb_init(&context) != 0)
-	{
-		return AIRSPY_ERROR_LIBUSB;
-	}
+		if (i < len)
+		{
+			fds[i].fd = device->event_fds[0];
+			fds[i].events = POLLIN;
+		}
+		*count = i + 1;
 
-	if (libusb_get_device_list(context, &devices) < 0)
-	{
-		return AIRSPY_ERROR_NOT_FOUND;
+		return AIRSPY_SUCCESS;
+#endif
 	}
 
-	i = 0;
-	output_count = 0;
-	while ((dev = devices[i++]) != NULL && (!serials || output_count < count))
+	int ADDCALL airspy_process_events(airspy_device_t* device)
 	{
-		libusb_get_device_descriptor(dev, &device_descriptor);
+		int error;
+		uint16_t* input_samples;
+		uint32_t dropped_buffers;
+		uint64_t timestamp;
+		struct timeval timeout = { 0, 0 };
 
-		if ((device_descriptor.idVendor == airspy_usb_vid) &&
-			(device_descriptor.idProduct == airspy_usb_pid))
+		if (!device->event_loop)
 		{
-			serial_descriptor_index = device_descriptor.iSerialNumber;
-			if (serial_descriptor_index > 0)
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		if (!device->streaming || device->stop_requested)
+		{
+			return AIRSPY_ERROR_STREAMING_STOPPED;
+		}
+
+		// Runs the completions that are ready, each one queues its buffer and signals the event fd
+		error = libusb_handle_events_timeout_completed(device->usb_context, &timeout, NULL);
+		if (error < 0 && error != LIBUSB_ERROR_INTERRUPTED)
+		{
+			device->stop_requested = true;
+		}
+
+		if (device->callback != NULL)
+		{
+			while (!device->stop_requested)
 			{
-				if (libusb_open(dev, &libusb_dev_handle) != 0)
+				input_samples = (uint16_t *) buffer_ring_acquire(&device->received_samples, &dropped_buffers, &timestamp, 0);
+				if (input_samples == NULL)
 				{
-					continue;
+					break;
 				}
 
-				serial_number_len = libusb_get_string_descriptor_ascii(libusb_dev_handle,
-					serial_descriptor_index,
-					serial_number,
-					sizeof(serial_number));
+				process_buffer(device, input_samples, dropped_buffers, timestamp);
 
-				if (serial_number_len == SERIAL_AIRSPY_EXPECTED_SIZE)
-				{
-					char *start, *end;
-					uint64_t serial;
+				buffer_ring_release(&device->received_samples);
+			}
 
-					serial_number[SERIAL_AIRSPY_EXPECTED_SIZE] = 0;
-					start = (char*)(serial_number + STR_PREFIX_SERIAL_AIRSPY_SIZE);
-					end = NULL;
-					serial = strtoull(start, &end, 16);
-					if (serial == 0 && start == end)
-					{
-						libusb_close(libusb_dev_handle);
-						continue;
-					}
+			clear_event_fd(device);
+		}
 
-					if (serials)
-					{
-						serials[output_count] = serial;
-					}
-					output_count++;
-				}
+		return device->stop_requested ? AIRSPY_ERROR_STREAMING_STOPPED : AIRSPY_SUCCESS;
+	}
 
-				libusb_close(libusb_dev_handle);
-			}
+	int ADDCALL airspy_si5351c_read(airspy_device_t* device, uint8_t register_number, uint8_t* value)
+	{
+		uint8_t temp_value;
+		int result;
+
+		temp_value = 0;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SI5351C_READ,
+			0,
+			register_number,
+			(unsigned char*)&temp_value,
+			1,
+			0);
+
+		if (result < 1)
+		{
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			*value = temp_value;
+			return AIRSPY_SUCCESS;
 		}
 	}
 
-	libusb_free_device_list(devices, 1);
-	libusb_exit(context);
-	return output_count;
-}
-
-	int ADDCALL airspy_open_sn(airspy_device_t** device, uint64_t serial_number)
+	int ADDCALL airspy_si5351c_write(airspy_device_t* device, uint8_t register_number, uint8_t value)
 	{
 		int result;
 
-		result = airspy_open_init(device, serial_number, FILE_DESCRIPTOR_UNUSED);
-		return result;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SI5351C_WRITE,
+			value,
+			register_number,
+			NULL,
+			0,
+			0);
+
+		if (result != 0)
+		{
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
+		}
 	}
 
-	int ADDCALL airspy_open_fd(airspy_device_t** device, int fd)
+	int ADDCALL airspy_r820t_read(airspy_device_t* device, uint8_t register_number, uint8_t* value)
 	{
 		int result;
 
-		result = airspy_open_init(device, SERIAL_NUMBER_UNUSED, fd);
-		return result;
-	}
-
-	int ADDCALL airspy_open(airspy_device_t** device)
-	{
-		int result;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_R820T_READ,
+			0,
+			register_number,
+			(unsigned char*)value,
+			1,
+			0);
 
-		result = airspy_open_init(device, SERIAL_NUMBER_UNUSED, FILE_DESCRIPTOR_UNUSED);
-		return result;
+		if (result < 1)
+		{
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
+		}
 	}
 
-	int ADDCALL airspy_close(airspy_device_t* device)
+	int ADDCALL airspy_r820t_write(airspy_device_t* device, uint8_t register_number, uint8_t value)
 	{
 		int result;
 
-		result = AIRSPY_SUCCESS;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_R820T_WRITE,
+			value,
+			register_number,
+			NULL,
+			0,
+			0);
 
-		if (device != NULL)
+		if (result != 0)
 		{
-			result = airspy_stop_rx(device);
-
-			iqconverter_float_free(device->cnv_f);
-			iqconverter_int16_free(device->cnv_i);
-
-			pthread_cond_destroy(&device->consumer_cv);
-			pthread_mutex_destroy(&device->consumer_mp);
-
-			free_transfers(device);
-			airspy_open_exit(device);
-			free(device->supported_samplerates);
-			free(device);
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
 		}
-
-		return result;
 	}
 
-	int ADDCALL airspy_get_samplerates(struct airspy_device* device, uint32_t* buffer, const uint32_t len)
+	int ADDCALL airspy_gpio_read(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t* value)
 	{
-		uint32_t i;
+		int result;
+		uint8_t port_pin;
 
-		if (len == 0)
-		{
-			*buffer = device->supported_samplerate_count;
-		}
-		else if (len <= device->supported_samplerate_count)
-		{
-			memcpy(buffer, device->supported_samplerates, len * sizeof(uint32_t));
+		port_pin = ((uint8_t)port) << 5;
+		port_pin = port_pin | pin;
 
-			if (!SAMPLE_TYPE_IS_IQ(device->sample_type))
-			{
-				for (i = 0; i < len; i++)
-				{
-					buffer[i] *= 2;
-				}
-			}
-		}
-		else
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_GPIO_READ,
+			0,
+			port_pin,
+			(unsigned char*)value,
+			1,
+			0);
+
+		if (result < 1)
 		{
-			return AIRSPY_ERROR_INVALID_PARAM;
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
 		}
-
-		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_set_samplerate(airspy_device_t* device, uint32_t samplerate)
+	int ADDCALL airspy_gpio_write(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t value)
 	{
 		int result;
-		uint8_t retval;
-		uint8_t length;
-		uint32_t i;
+		uint8_t port_pin;
 
-		if (samplerate >= MIN_SAMPLERATE_BY_VALUE)
-		{
-			for (i = 0; i < device->supported_samplerate_count; i++)
-			{
-				if (samplerate == device->supported_samplerates[i])
-				{
-					samplerate = i;
-					break;
-				}
-			}
+		port_pin = ((uint8_t)port) << 5;
+		port_pin = port_pin | pin;
 
-			if (samplerate >= MIN_SAMPLERATE_BY_VALUE)
-			{
-				if (SAMPLE_TYPE_IS_IQ(device->sample_type))
-				{
-					samplerate *= 2;
-				}
-				samplerate /= 1000;
-			}
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_GPIO_WRITE,
+			value,
+			port_pin,
+			NULL,
+			0,
+			0);
+
+		if (result != 0)
+		{
+			return AIRSPY_ERROR_LIBUSB;
 		}
+		else {
+			return AIRSPY_SUCCESS;
+		}
+	}
 
-		libusb_clear_halt(device->usb_device, LIBUSB_ENDPOINT_IN | 1);
 
-		length = 1;
+	int ADDCALL airspy_gpiodir_read(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t* value)
+	{
+		int result;
+		uint8_t port_pin;
+
+		port_pin = ((uint8_t)port) << 5;
+		port_pin = port_pin | pin;
 
 		result = libusb_control_transfer(
 			device->usb_device,
 			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SET_SAMPLERATE,
+			AIRSPY_GPIODIR_READ,
 			0,
-			samplerate,
-			&retval,
-			length,
-			0
-			);
+			port_pin,
+			(unsigned char*)value,
+			1,
+			0);
 
-		if (result < length)
+		if (result < 1)
 		{
 			return AIRSPY_ERROR_LIBUSB;
 		}
@@ -1158,19 +2972,23 @@ int airspy_list_devices(uint64_t *serials, int count)
 		}
 	}
 
-	int ADDCALL airspy_set_receiver_mode(airspy_device_t* device, receiver_mode_t value)
+	int ADDCALL airspy_gpiodir_write(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t value)
 	{
 		int result;
+		uint8_t port_pin;
+
+		port_pin = ((uint8_t)port) << 5;
+		port_pin = port_pin | pin;
+
 		result = libusb_control_transfer(
 			device->usb_device,
 			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_RECEIVER_MODE,
+			AIRSPY_GPIODIR_WRITE,
 			value,
-			0,
+			port_pin,
 			NULL,
 			0,
-			0
-			);
+			0);
 
 		if (result != 0)
 		{
@@ -1181,88 +2999,93 @@ int airspy_list_devices(uint64_t *serials, int count)
 		}
 	}
 
-	int ADDCALL airspy_start_rx(airspy_device_t* device, airspy_sample_block_cb_fn callback, void* ctx)
+	int ADDCALL airspy_spiflash_erase(airspy_device_t* device)
 	{
 		int result;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SPIFLASH_ERASE,
+			0,
+			0,
+			NULL,
+			0,
+			0);
 
-		iqconverter_float_reset(device->cnv_f);
-		iqconverter_int16_reset(device->cnv_i);
-
-		memset(device->dropped_buffers_queue, 0, RAW_BUFFER_COUNT * sizeof(uint32_t));
-		device->dropped_buffers = 0;
-
-		result = airspy_set_receiver_mode(device, RECEIVER_MODE_OFF);
-		if (result != AIRSPY_SUCCESS)
+		if (result != 0)
 		{
-			return result;
+			return AIRSPY_ERROR_LIBUSB;
 		}
-
-		libusb_clear_halt(device->usb_device, LIBUSB_ENDPOINT_IN | 1);
-
-		result = airspy_set_receiver_mode(device, RECEIVER_MODE_RX);
-		if (result == AIRSPY_SUCCESS)
-		{
-			device->ctx = ctx;
-			result = create_io_threads(device, callback);
+		else {
+			return AIRSPY_SUCCESS;
 		}
-
-		return result;
 	}
 
-	int ADDCALL airspy_stop_rx(airspy_device_t* device)
+	int ADDCALL airspy_spiflash_erase_sector(airspy_device_t* device, const uint16_t sector_num)
 	{
-		int result1, result2;
-		result1 = kill_io_threads(device);
+		int result;
+		result = libusb_control_transfer(
+			device->usb_device,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SPIFLASH_ERASE_SECTOR,
+			sector_num,
+			0,
+			NULL,
+			0,
+			0);
 
-		result2 = airspy_set_receiver_mode(device, RECEIVER_MODE_OFF);
-		if (result2 != AIRSPY_SUCCESS)
+		if (result != 0)
 		{
-			return result2;
+			return AIRSPY_ERROR_LIBUSB;
+		}
+		else {
+			return AIRSPY_SUCCESS;
 		}
-		return result1;
 	}
 
-	int ADDCALL airspy_si5351c_read(airspy_device_t* device, uint8_t register_number, uint8_t* value)
+	int ADDCALL airspy_spiflash_write(airspy_device_t* device, const uint32_t address, const uint16_t length, unsigned char* const data)
 	{
-		uint8_t temp_value;
 		int result;
 
-		temp_value = 0;
+		if (address > 0x0FFFFF)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
 		result = libusb_control_transfer(
 			device->usb_device,
-			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SI5351C_READ,
-			0,
-			register_number,
-			(unsigned char*)&temp_value,
-			1,
+			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SPIFLASH_WRITE,
+			address >> 16,
+			address & 0xFFFF,
+			data,
+			length,
 			0);
 
-		if (result < 1)
+		if (result < length)
 		{
 			return AIRSPY_ERROR_LIBUSB;
 		}
 		else {
-			*value = temp_value;
 			return AIRSPY_SUCCESS;
 		}
 	}
 
-	int ADDCALL airspy_si5351c_write(airspy_device_t* device, uint8_t register_number, uint8_t value)
+	int ADDCALL airspy_spiflash_read(airspy_device_t* device, const uint32_t address, const uint16_t length, unsigned char* data)
 	{
 		int result;
 
 		result = libusb_control_transfer(
 			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SI5351C_WRITE,
-			value,
-			register_number,
-			NULL,
-			0,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_SPIFLASH_READ,
+			address >> 16,
+			address & 0xFFFF,
+			data,
+			length,
 			0);
 
-		if (result != 0)
+		if (result < length)
 		{
 			return AIRSPY_ERROR_LIBUSB;
 		}
@@ -1271,17 +3094,16 @@ int airspy_list_devices(uint64_t *serials, int count)
 		}
 	}
 
-	int ADDCALL airspy_r820t_read(airspy_device_t* device, uint8_t register_number, uint8_t* value)
+	int ADDCALL airspy_board_id_read(airspy_device_t* device, uint8_t* value)
 	{
 		int result;
-
 		result = libusb_control_transfer(
 			device->usb_device,
 			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_R820T_READ,
+			AIRSPY_BOARD_ID_READ,
 			0,
-			register_number,
-			(unsigned char*)value,
+			0,
+			value,
 			1,
 			0);
 
@@ -1294,75 +3116,102 @@ int airspy_list_devices(uint64_t *serials, int count)
 		}
 	}
 
-	int ADDCALL airspy_r820t_write(airspy_device_t* device, uint8_t register_number, uint8_t value)
+	int ADDCALL airspy_version_string_read(airspy_device_t* device, char* version, uint8_t length)
 	{
+#define VERSION_LOCAL_SIZE (128)
 		int result;
+		char version_local[VERSION_LOCAL_SIZE] = "";
 
 		result = libusb_control_transfer(
 			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_R820T_WRITE,
-			value,
-			register_number,
-			NULL,
+			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+			AIRSPY_VERSION_STRING_READ,
+			0,
 			0,
+			(unsigned char*)version_local,
+			(VERSION_LOCAL_SIZE - 1),
 			0);
 
-		if (result != 0)
+		if (result < 0)
 		{
 			return AIRSPY_ERROR_LIBUSB;
 		}
-		else {
-			return AIRSPY_SUCCESS;
+		else
+		{
+			if (length > 0)
+			{
+				const int num_bytes_to_copy = (length > VERSION_LOCAL_SIZE ? VERSION_LOCAL_SIZE : length) - 1;
+				memcpy(version, version_local, num_bytes_to_copy);
+				version[num_bytes_to_copy] = 0;
+				return AIRSPY_SUCCESS;
+			}
+			else
+			{
+				return AIRSPY_ERROR_INVALID_PARAM;
+			}
 		}
 	}
 
-	int ADDCALL airspy_gpio_read(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t* value)
+	int ADDCALL airspy_board_partid_serialno_read(airspy_device_t* device, airspy_read_partid_serialno_t* read_partid_serialno)
 	{
+		uint8_t length;
 		int result;
-		uint8_t port_pin;
-
-		port_pin = ((uint8_t)port) << 5;
-		port_pin = port_pin | pin;
 
+		length = sizeof(airspy_read_partid_serialno_t);
 		result = libusb_control_transfer(
 			device->usb_device,
 			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_GPIO_READ,
+			AIRSPY_BOARD_PARTID_SERIALNO_READ,
 			0,
-			port_pin,
-			(unsigned char*)value,
-			1,
+			0,
+			(unsigned char*)read_partid_serialno,
+			length,
 			0);
 
-		if (result < 1)
+		if (result < length)
 		{
 			return AIRSPY_ERROR_LIBUSB;
 		}
 		else {
+
+			read_partid_serialno->part_id[0] = TO_LE(read_partid_serialno->part_id[0]);
+			read_partid_serialno->part_id[1] = TO_LE(read_partid_serialno->part_id[1]);
+			read_partid_serialno->serial_no[0] = TO_LE(read_partid_serialno->serial_no[0]);
+			read_partid_serialno->serial_no[1] = TO_LE(read_partid_serialno->serial_no[1]);
+			read_partid_serialno->serial_no[2] = TO_LE(read_partid_serialno->serial_no[2]);
+			read_partid_serialno->serial_no[3] = TO_LE(read_partid_serialno->serial_no[3]);
+
 			return AIRSPY_SUCCESS;
 		}
 	}
 
-	int ADDCALL airspy_gpio_write(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t value)
+	int ADDCALL airspy_set_sample_type(struct airspy_device* device, enum airspy_sample_type sample_type)
+	{
+		device->sample_type = sample_type;
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_freq(airspy_device_t* device, const uint32_t freq_hz)
 	{
+		set_freq_params_t set_freq_params;
+		uint8_t length;
 		int result;
-		uint8_t port_pin;
 
-		port_pin = ((uint8_t)port) << 5;
-		port_pin = port_pin | pin;
+		set_freq_params.freq_hz = TO_LE(freq_hz);
+		length = sizeof(set_freq_params_t);
 
 		result = libusb_control_transfer(
 			device->usb_device,
 			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_GPIO_WRITE,
-			value,
-			port_pin,
-			NULL,
+			AIRSPY_SET_FREQ,
 			0,
-			0);
+			0,
+			(unsigned char*)&set_freq_params,
+			length,
+			0
+			);
 
-		if (result != 0)
+		if (result < length)
 		{
 			return AIRSPY_ERROR_LIBUSB;
 		}
@@ -1371,304 +3220,382 @@ int airspy_list_devices(uint64_t *serials, int count)
 		}
 	}
 
+	int ADDCALL airspy_set_conversion_filter_float32(struct airspy_device* device, const float *kernel, const uint32_t len)
+	{
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
+
+		iqconverter_float_free(device->cnv_f);
+		device->cnv_f = iqconverter_float_create(kernel, len);
 
-	int ADDCALL airspy_gpiodir_read(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t* value)
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_conversion_filter_int16(struct airspy_device* device, const int16_t *kernel, const uint32_t len)
 	{
-		int result;
-		uint8_t port_pin;
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
 
-		port_pin = ((uint8_t)port) << 5;
-		port_pin = port_pin | pin;
+		iqconverter_int16_free(device->cnv_i);
+		device->cnv_i = iqconverter_int16_create(kernel, len);
 
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_GPIODIR_READ,
-			0,
-			port_pin,
-			(unsigned char*)value,
-			1,
-			0);
+		return AIRSPY_SUCCESS;
+	}
 
-		if (result < 1)
+	int ADDCALL airspy_set_conversion_threads(struct airspy_device* device, uint32_t count)
+	{
+		if (count < 1 || count > MAX_CONVERSION_THREADS)
 		{
-			return AIRSPY_ERROR_LIBUSB;
+			return AIRSPY_ERROR_INVALID_PARAM;
 		}
-		else {
-			return AIRSPY_SUCCESS;
+
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
 		}
+
+		device->conversion_threads = count;
+
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_gpiodir_write(airspy_device_t* device, airspy_gpio_port_t port, airspy_gpio_pin_t pin, uint8_t value)
+	int ADDCALL airspy_set_wait_strategy(struct airspy_device* device, enum airspy_wait_strategy strategy)
 	{
-		int result;
-		uint8_t port_pin;
+		if (strategy != AIRSPY_WAIT_BLOCK && strategy != AIRSPY_WAIT_SPIN && strategy != AIRSPY_WAIT_SPIN_THEN_BLOCK)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
 
-		port_pin = ((uint8_t)port) << 5;
-		port_pin = port_pin | pin;
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
 
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_GPIODIR_WRITE,
-			value,
-			port_pin,
-			NULL,
-			0,
-			0);
+		device->wait_strategy = strategy;
 
-		if (result != 0)
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_transfer_count(struct airspy_device* device, uint32_t count)
+	{
+		if (count < 1 || count > MAX_TRANSFER_COUNT)
 		{
-			return AIRSPY_ERROR_LIBUSB;
+			return AIRSPY_ERROR_INVALID_PARAM;
 		}
-		else {
-			return AIRSPY_SUCCESS;
+
+		return reallocate_transfers(device, count, device->transfer_size, device->queue_depth);
+	}
+
+	int ADDCALL airspy_set_transfer_size(struct airspy_device* device, uint32_t size)
+	{
+		if (size > MAX_TRANSFER_SIZE)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
 		}
+
+		return reallocate_transfers(device, device->transfer_count, size, device->queue_depth);
 	}
 
-	int ADDCALL airspy_spiflash_erase(airspy_device_t* device)
+	int ADDCALL airspy_get_transfer_size(struct airspy_device* device, uint32_t* size)
 	{
-		int result;
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SPIFLASH_ERASE,
-			0,
-			0,
-			NULL,
-			0,
-			0);
+		*size = device->buffer_size;
 
-		if (result != 0)
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_queue_depth(struct airspy_device* device, uint32_t depth)
+	{
+		if (depth < 1 || depth > MAX_QUEUE_DEPTH)
 		{
-			return AIRSPY_ERROR_LIBUSB;
+			return AIRSPY_ERROR_INVALID_PARAM;
 		}
-		else {
-			return AIRSPY_SUCCESS;
+
+		return reallocate_transfers(device, device->transfer_count, device->transfer_size, depth);
+	}
+
+	int ADDCALL airspy_get_queue_depth(struct airspy_device* device, uint32_t* depth)
+	{
+		*depth = device->received_samples.count;
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_callback_block_size(struct airspy_device* device, uint32_t sample_count)
+	{
+		if (sample_count > MAX_CALLBACK_BLOCK_SIZE)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
+
+		device->block_size = sample_count;
+
+		// The block buffer is sized along with the transfers
+		return reallocate_transfers(device, device->transfer_count, device->transfer_size, device->queue_depth);
+	}
+
+	int ADDCALL airspy_set_buffer_pool(struct airspy_device* device, uint32_t count, void* memory, size_t size)
+	{
+		if (count < 1 || count > MAX_POOL_COUNT)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
 		}
+
+		device->pool_count = count;
+		device->pool_memory = memory;
+		device->pool_memory_size = memory != NULL ? size : 0;
+
+		return reallocate_transfers(device, device->transfer_count, device->transfer_size, device->queue_depth);
+	}
+
+	int ADDCALL airspy_get_buffer_pool_size(struct airspy_device* device, uint32_t count, size_t* size)
+	{
+		*size = get_pool_stride(device) * count;
+
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_spiflash_erase_sector(airspy_device_t* device, const uint16_t sector_num)
+	int ADDCALL airspy_buffer_retain(struct airspy_device* device, void* samples)
 	{
-		int result;
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SPIFLASH_ERASE_SECTOR,
-			sector_num,
-			0,
-			NULL,
-			0,
-			0);
+		uint32_t index;
 
-		if (result != 0)
+		if (device->pool_count < 2)
 		{
-			return AIRSPY_ERROR_LIBUSB;
+			return AIRSPY_ERROR_NO_MEM;
 		}
-		else {
-			return AIRSPY_SUCCESS;
+
+		index = find_pool_buffer(device, samples);
+		if (index >= device->pool_count)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
 		}
+
+		ATOMIC_INC(&device->pool_refs[index]);
+
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_spiflash_write(airspy_device_t* device, const uint32_t address, const uint16_t length, unsigned char* const data)
+	int ADDCALL airspy_buffer_release(struct airspy_device* device, void* samples)
 	{
-		int result;
+		uint32_t index;
 
-		if (address > 0x0FFFFF)
+		index = find_pool_buffer(device, samples);
+		if (index >= device->pool_count || ATOMIC_LOAD(&device->pool_refs[index]) <= 0)
 		{
 			return AIRSPY_ERROR_INVALID_PARAM;
 		}
 
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SPIFLASH_WRITE,
-			address >> 16,
-			address & 0xFFFF,
-			data,
-			length,
-			0);
-
-		if (result < length)
+		if (ATOMIC_DEC(&device->pool_refs[index]) == 0)
 		{
-			return AIRSPY_ERROR_LIBUSB;
-		}
-		else {
-			return AIRSPY_SUCCESS;
+			pthread_mutex_lock(&device->pool_mp);
+			pthread_cond_signal(&device->pool_cv);
+			pthread_mutex_unlock(&device->pool_mp);
 		}
+
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_spiflash_read(airspy_device_t* device, const uint32_t address, const uint16_t length, unsigned char* data)
+	int ADDCALL airspy_set_low_latency(struct airspy_device* device, uint8_t value)
 	{
-		int result;
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
 
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SPIFLASH_READ,
-			address >> 16,
-			address & 0xFFFF,
-			data,
-			length,
-			0);
+		device->buffer_auto_tune = false;
 
-		if (result < length)
+		if (value)
 		{
-			return AIRSPY_ERROR_LIBUSB;
-		}
-		else {
-			return AIRSPY_SUCCESS;
+			device->wait_strategy = AIRSPY_WAIT_SPIN_THEN_BLOCK;
+			return reallocate_transfers(device, LOW_LATENCY_TRANSFER_COUNT, LOW_LATENCY_TRANSFER_SIZE, LOW_LATENCY_QUEUE_DEPTH);
 		}
+
+		device->wait_strategy = AIRSPY_WAIT_BLOCK;
+		return reallocate_transfers(device, DEFAULT_TRANSFER_COUNT, 0, RAW_BUFFER_COUNT);
 	}
 
-	int ADDCALL airspy_board_id_read(airspy_device_t* device, uint8_t* value)
+	int ADDCALL airspy_get_latency(struct airspy_device* device, airspy_latency_t* latency)
 	{
-		int result;
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_BOARD_ID_READ,
-			0,
-			0,
-			value,
-			1,
-			0);
+		*latency = device->latency;
 
-		if (result < 1)
-		{
-			return AIRSPY_ERROR_LIBUSB;
-		}
-		else {
-			return AIRSPY_SUCCESS;
-		}
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_version_string_read(airspy_device_t* device, char* version, uint8_t length)
+	int ADDCALL airspy_get_stats(struct airspy_device* device, airspy_stats_t* stats)
 	{
-#define VERSION_LOCAL_SIZE (128)
-		int result;
-		char version_local[VERSION_LOCAL_SIZE] = "";
-
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_VERSION_STRING_READ,
-			0,
-			0,
-			(unsigned char*)version_local,
-			(VERSION_LOCAL_SIZE - 1),
-			0);
+		int i;
 
-		if (result < 0)
+		stats->bytes = STAT_LOAD(&device->stats.bytes);
+		stats->buffers = STAT_LOAD(&device->stats.buffers);
+		stats->samples = STAT_LOAD(&device->stats.samples);
+		stats->queue_overruns = STAT_LOAD(&device->stats.queue_overruns);
+		stats->pool_overruns = STAT_LOAD(&device->stats.pool_overruns);
+		stats->queue_high_water = STAT_LOAD(&device->stats.queue_high_water);
+		for (i = 0; i < AIRSPY_TRANSFER_ERROR_END; i++)
 		{
-			return AIRSPY_ERROR_LIBUSB;
+			stats->transfer_errors[i] = STAT_LOAD(&device->stats.transfer_errors[i]);
 		}
-		else
+		stats->resubmit_failures = STAT_LOAD(&device->stats.resubmit_failures);
+		stats->callback_stops = STAT_LOAD(&device->stats.callback_stops);
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_stage_timing(struct airspy_device* device, uint8_t value)
+	{
+		if (device->streaming)
 		{
-			if (length > 0)
-			{
-				const int num_bytes_to_copy = (length > VERSION_LOCAL_SIZE ? VERSION_LOCAL_SIZE : length) - 1;
-				memcpy(version, version_local, num_bytes_to_copy);
-				version[num_bytes_to_copy] = 0;
-				return AIRSPY_SUCCESS;
-			}
-			else
-			{
-				return AIRSPY_ERROR_INVALID_PARAM;
-			}
+			return AIRSPY_ERROR_BUSY;
 		}
+
+		device->stage_timing = value ? true : false;
+
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_board_partid_serialno_read(airspy_device_t* device, airspy_read_partid_serialno_t* read_partid_serialno)
+	int ADDCALL airspy_get_stage_timing(struct airspy_device* device, enum airspy_stage stage, airspy_stage_timing_t* timing)
 	{
-		uint8_t length;
-		int result;
-
-		length = sizeof(airspy_read_partid_serialno_t);
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_BOARD_PARTID_SERIALNO_READ,
-			0,
-			0,
-			(unsigned char*)read_partid_serialno,
-			length,
-			0);
+		histogram_t times;
 
-		if (result < length)
+		if (stage < AIRSPY_STAGE_CONVERT || stage >= AIRSPY_STAGE_END)
 		{
-			return AIRSPY_ERROR_LIBUSB;
+			return AIRSPY_ERROR_INVALID_PARAM;
 		}
-		else {
 
-			read_partid_serialno->part_id[0] = TO_LE(read_partid_serialno->part_id[0]);
-			read_partid_serialno->part_id[1] = TO_LE(read_partid_serialno->part_id[1]);
-			read_partid_serialno->serial_no[0] = TO_LE(read_partid_serialno->serial_no[0]);
-			read_partid_serialno->serial_no[1] = TO_LE(read_partid_serialno->serial_no[1]);
-			read_partid_serialno->serial_no[2] = TO_LE(read_partid_serialno->serial_no[2]);
-			read_partid_serialno->serial_no[3] = TO_LE(read_partid_serialno->serial_no[3]);
+		// A consistent enough copy while the stage is being timed
+		times = device->stage_times[stage];
 
-			return AIRSPY_SUCCESS;
-		}
+		timing->count = times.count;
+		timing->min_ns = times.min;
+		timing->avg_ns = times.count != 0 ? times.sum / times.count : 0;
+		timing->p99_ns = histogram_percentile(&times, 0.99);
+		timing->max_ns = times.max;
+
+		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_set_sample_type(struct airspy_device* device, enum airspy_sample_type sample_type)
+	int ADDCALL airspy_get_histogram(struct airspy_device* device, enum airspy_histogram which, airspy_histogram_t* histogram)
 	{
-		device->sample_type = sample_type;
+		histogram_t values;
+
+		if (which < AIRSPY_HISTOGRAM_QUEUE_WAIT || which >= AIRSPY_HISTOGRAM_END)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		values = device->histograms[which];
+
+		histogram->count = values.count;
+		histogram->max = values.max;
+		histogram->p50 = histogram_percentile(&values, 0.5);
+		histogram->p99 = histogram_percentile(&values, 0.99);
+		histogram_fold_log2(&values, histogram->buckets, AIRSPY_HISTOGRAM_BUCKETS);
+
 		return AIRSPY_SUCCESS;
 	}
 
-	int ADDCALL airspy_set_freq(airspy_device_t* device, const uint32_t freq_hz)
+	int ADDCALL airspy_set_callback_watchdog(struct airspy_device* device, uint32_t budget_us, airspy_watchdog_cb_fn watchdog, void* ctx)
 	{
-		set_freq_params_t set_freq_params;
-		uint8_t length;
-		int result;
+		if (device->streaming)
+		{
+			return AIRSPY_ERROR_BUSY;
+		}
 
-		set_freq_params.freq_hz = TO_LE(freq_hz);
-		length = sizeof(set_freq_params_t);
+		if (watchdog != NULL && budget_us == 0)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
 
-		result = libusb_control_transfer(
-			device->usb_device,
-			LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
-			AIRSPY_SET_FREQ,
-			0,
-			0,
-			(unsigned char*)&set_freq_params,
-			length,
-			0
-			);
+		device->watchdog = watchdog;
+		device->watchdog_ctx = ctx;
+		device->watchdog_budget_us = budget_us;
 
-		if (result < length)
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_set_buffer_auto_tune(struct airspy_device* device, uint8_t value)
+	{
+		if (device->streaming)
 		{
-			return AIRSPY_ERROR_LIBUSB;
-		}
-		else {
-			return AIRSPY_SUCCESS;
+			return AIRSPY_ERROR_BUSY;
 		}
+
+		device->buffer_auto_tune = value ? true : false;
+
+		return reallocate_transfers(device, device->transfer_count, device->transfer_size, device->queue_depth);
 	}
 
-	int ADDCALL airspy_set_conversion_filter_float32(struct airspy_device* device, const float *kernel, const uint32_t len)
+	int ADDCALL airspy_set_memory_options(struct airspy_device* device, uint32_t flags, int numa_node)
 	{
+		if ((flags & ~(AIRSPY_MEMORY_HUGEPAGES | AIRSPY_MEMORY_LOCKED)) != 0 || numa_node < AIRSPY_NUMA_THREAD_NODE)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
 		if (device->streaming)
 		{
 			return AIRSPY_ERROR_BUSY;
 		}
 
-		iqconverter_float_free(device->cnv_f);
-		device->cnv_f = iqconverter_float_create(kernel, len);
+		device->memory_flags = flags;
+		device->numa_node = numa_node;
 
-		return AIRSPY_SUCCESS;
+		return reallocate_transfers(device, device->transfer_count, device->transfer_size, device->queue_depth);
 	}
 
-	int ADDCALL airspy_set_conversion_filter_int16(struct airspy_device* device, const int16_t *kernel, const uint32_t len)
+	int ADDCALL airspy_set_thread_scheduling(struct airspy_device* device, enum airspy_thread thread, uint64_t cpu_mask, enum airspy_sched_policy policy, int priority)
 	{
+		thread_sched_t* sched;
+
+		if (thread < 0 || thread >= AIRSPY_THREAD_END || policy < AIRSPY_SCHED_DEFAULT || policy > AIRSPY_SCHED_RR)
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
+		if (policy != AIRSPY_SCHED_DEFAULT && (priority < 1 || priority > 99))
+		{
+			return AIRSPY_ERROR_INVALID_PARAM;
+		}
+
 		if (device->streaming)
 		{
 			return AIRSPY_ERROR_BUSY;
 		}
 
-		iqconverter_int16_free(device->cnv_i);
-		device->cnv_i = iqconverter_int16_create(kernel, len);
+		sched = &device->thread_sched[thread];
+		sched->cpu_mask = cpu_mask;
+		sched->policy = policy;
+		sched->priority = policy != AIRSPY_SCHED_DEFAULT ? priority : 0;
+
+		// Moves the buffers along with the threads
+		if (device->numa_node == AIRSPY_NUMA_THREAD_NODE && thread != AIRSPY_THREAD_CONVERSION)
+		{
+			return reallocate_transfers(device, device->transfer_count, device->transfer_size, device->queue_depth);
+		}
+
+		return AIRSPY_SUCCESS;
+	}
+
+	int ADDCALL airspy_get_memory_options(struct airspy_device* device, uint32_t* flags)
+	{
+		*flags = device->arena.flags;
+		if (device->usb_memory != NULL)
+		{
+			*flags |= AIRSPY_MEMORY_ZERO_COPY;
+		}
 
 		return AIRSPY_SUCCESS;
 	}
@@ -1928,7 +3855,7 @@ int airspy_list_devices(uint64_t *serials, int count)
 			free_transfers(device);
 
 			device->packing_enabled = packing_enabled;
-			device->buffer_size = packing_enabled ? (6144 * 24) : 262144;
+			device->buffer_size = get_buffer_size(device);
 
 			result = allocate_transfers(device);
 			if (result != 0)
@@ -1964,6 +3891,9 @@ int airspy_list_devices(uint64_t *serials, int count)
 		case AIRSPY_ERROR_BUSY:
 			return "AIRSPY_ERROR_BUSY";
 
+		case AIRSPY_ERROR_TIMEOUT:
+			return "AIRSPY_ERROR_TIMEOUT";
+
 		case AIRSPY_ERROR_NO_MEM:
 			return "AIRSPY_ERROR_NO_MEM";
 
@@ -1987,6 +3917,63 @@ int airspy_list_devices(uint64_t *serials, int count)
 		}
 	}
 
+	uint32_t ADDCALL airspy_get_cpu_features(void)
+	{
+		return cpu_features_detect();
+	}
+
+	const char* ADDCALL airspy_get_dsp_kernel_variant(struct airspy_device* device, enum airspy_dsp_kernel kernel)
+	{
+		const char* variant;
+
+		if (kernel < AIRSPY_DSP_UNPACK || kernel >= AIRSPY_DSP_END)
+		{
+			return NULL;
+		}
+
+		variant = sample_converter_variant(kernel);
+		if (variant == NULL)
+		{
+			if (device->sample_type == AIRSPY_SAMPLE_FLOAT32_IQ || device->sample_type == AIRSPY_SAMPLE_FLOAT32_REAL)
+			{
+				variant = iqconverter_float_variant(device->cnv_f, kernel);
+			}
+			else
+			{
+				variant = iqconverter_int16_variant(device->cnv_i, kernel);
+			}
+		}
+
+		return variant;
+	}
+
+	const char* ADDCALL airspy_dsp_kernel_name(enum airspy_dsp_kernel kernel)
+	{
+		switch (kernel)
+		{
+		case AIRSPY_DSP_UNPACK:
+			return "unpack";
+
+		case AIRSPY_DSP_CONVERT:
+			return "convert";
+
+		case AIRSPY_DSP_REMOVE_DC:
+			return "remove_dc";
+
+		case AIRSPY_DSP_TRANSLATE:
+			return "translate";
+
+		case AIRSPY_DSP_FIR:
+			return "fir";
+
+		case AIRSPY_DSP_DELAY:
+			return "delay";
+
+		default:
+			return "unknown";
+		}
+	}
+
 	const char* ADDCALL airspy_board_id_name(enum airspy_board_id board_id)
 	{
 		switch (board_id)
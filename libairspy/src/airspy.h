@@ -26,6 +26,7 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 #define __AIRSPY_H__
 
 #include <stdint.h>
+#include <stddef.h>
 #include "airspy_commands.h"
 
 #define AIRSPY_VERSION "1.0.11"
@@ -66,6 +67,7 @@ enum airspy_error
 	AIRSPY_ERROR_INVALID_PARAM = -2,
 	AIRSPY_ERROR_NOT_FOUND = -5,
 	AIRSPY_ERROR_BUSY = -6,
+	AIRSPY_ERROR_TIMEOUT = -7,
 	AIRSPY_ERROR_NO_MEM = -11,
 	AIRSPY_ERROR_UNSUPPORTED = -12,
 	AIRSPY_ERROR_LIBUSB = -1000,
@@ -92,9 +94,99 @@ enum airspy_sample_type
 	AIRSPY_SAMPLE_END = 6           /* Number of supported sample types */
 };
 
+enum airspy_cpu_feature
+{
+	AIRSPY_CPU_SSE2 = (1 << 0),
+	AIRSPY_CPU_SSSE3 = (1 << 1),
+	AIRSPY_CPU_SSE41 = (1 << 2),
+	AIRSPY_CPU_AVX2 = (1 << 3),
+	AIRSPY_CPU_FMA = (1 << 4),
+	AIRSPY_CPU_AVX512F = (1 << 5),
+	AIRSPY_CPU_AVX512BW = (1 << 6)
+};
+
+enum airspy_dsp_kernel
+{
+	AIRSPY_DSP_UNPACK = 0,    /* 12bit unpacking (+ conversion) of packed samples */
+	AIRSPY_DSP_CONVERT = 1,   /* Offset and scaling of unpacked samples */
+	AIRSPY_DSP_REMOVE_DC = 2,
+	AIRSPY_DSP_TRANSLATE = 3, /* fs/4 translation */
+	AIRSPY_DSP_FIR = 4,       /* Half-band FIR */
+	AIRSPY_DSP_DELAY = 5,
+	AIRSPY_DSP_END = 6        /* Number of DSP kernels */
+};
+
+/* Per buffer processing stages timed by airspy_set_stage_timing() */
+enum airspy_stage
+{
+	AIRSPY_STAGE_CONVERT = 0,  /* Unpacking and conversion to the sample type */
+	AIRSPY_STAGE_FILTER = 1,   /* DC removal, fs/4 translation and half-band FIR of IQ samples */
+	AIRSPY_STAGE_CALLBACK = 2, /* One call of the user callback */
+	AIRSPY_STAGE_END = 3       /* Number of stages */
+};
+
+/* Streaming histograms, see airspy_get_histogram() */
+enum airspy_histogram
+{
+	AIRSPY_HISTOGRAM_QUEUE_WAIT = 0,   /* Microseconds from the USB completion to the processing of the buffer */
+	AIRSPY_HISTOGRAM_CALLBACK = 1,     /* Microseconds spent in one call of the user callback */
+	AIRSPY_HISTOGRAM_USB_INTERVAL = 2, /* Microseconds between two USB completions, its spread is the USB jitter */
+	AIRSPY_HISTOGRAM_QUEUE_DEPTH = 3,  /* USB buffers waiting for the consumer after each completion */
+	AIRSPY_HISTOGRAM_END = 4           /* Number of histograms */
+};
+
+/* How the consumer thread waits for the next USB buffer */
+enum airspy_wait_strategy
+{
+	AIRSPY_WAIT_BLOCK = 0,          /* Sleep until woken by the USB thread (default) */
+	AIRSPY_WAIT_SPIN = 1,           /* Busy poll, lowest latency but keeps one core busy */
+	AIRSPY_WAIT_SPIN_THEN_BLOCK = 2 /* Busy poll for a few tens of microseconds, then sleep */
+};
+
+/* Backing of the streaming buffers, see airspy_set_memory_options() */
+enum airspy_memory_flags
+{
+	AIRSPY_MEMORY_HUGEPAGES = (1 << 0), /* 2 MiB pages, falls back to transparent hugepages on Linux */
+	AIRSPY_MEMORY_LOCKED = (1 << 1),    /* Locked in RAM, subject to RLIMIT_MEMLOCK / the working set size */
+	AIRSPY_MEMORY_ZERO_COPY = (1 << 2)  /* Reported only: transfers mapped from usbfs (Linux), not copied by the kernel */
+};
+
+/* Library threads of a device, see airspy_set_thread_scheduling() */
+enum airspy_thread
+{
+	AIRSPY_THREAD_TRANSFER = 0,   /* USB event handling */
+	AIRSPY_THREAD_CONSUMER = 1,   /* Conversion and callbacks */
+	AIRSPY_THREAD_CONVERSION = 2, /* Extra threads of airspy_set_conversion_threads() */
+	AIRSPY_THREAD_END = 3         /* Number of thread kinds */
+};
+
+enum airspy_sched_policy
+{
+	AIRSPY_SCHED_DEFAULT = 0, /* SCHED_OTHER, THREAD_PRIORITY_HIGHEST on Windows */
+	AIRSPY_SCHED_FIFO = 1,    /* THREAD_PRIORITY_TIME_CRITICAL on Windows */
+	AIRSPY_SCHED_RR = 2       /* THREAD_PRIORITY_TIME_CRITICAL on Windows */
+};
+
+/* Failed USB transfers, see airspy_stats_t. Same values as enum libusb_transfer_status but for AIRSPY_TRANSFER_SHORT */
+enum airspy_transfer_error
+{
+	AIRSPY_TRANSFER_SHORT = 0,     /* Completed with less data than requested */
+	AIRSPY_TRANSFER_ERROR = 1,
+	AIRSPY_TRANSFER_TIMED_OUT = 2,
+	AIRSPY_TRANSFER_CANCELLED = 3,
+	AIRSPY_TRANSFER_STALL = 4,
+	AIRSPY_TRANSFER_NO_DEVICE = 5,
+	AIRSPY_TRANSFER_OVERFLOW = 6,
+	AIRSPY_TRANSFER_ERROR_END = 7  /* Number of transfer errors */
+};
+
+/* numa_node of airspy_set_memory_options(): the node of the CPUs the consumer (else transfer) thread is pinned to */
+#define AIRSPY_NUMA_THREAD_NODE (-2)
+
 #define MAX_CONFIG_PAGE_SIZE (0x10000)
 
 struct airspy_device;
+struct airspy_context;
 
 typedef struct {
 	struct airspy_device* device;
@@ -105,6 +197,73 @@ typedef struct {
 	enum airspy_sample_type sample_type;
 } airspy_transfer_t, airspy_transfer;
 
+typedef struct {
+	int fd;
+	short events;
+} airspy_pollfd_t;
+
+/*
+ * Latency budget, in microseconds, from the first sample of a buffer
+ * reaching the host to the return of its callback:
+ *   transfer_us  time to fill one transfer, 6.5 ms for 256 KiB and 0.4 ms for 16 KiB at 10 MSPS unpacked
+ *   queue_us     time the buffer waited for the consumer thread, bounded by queue depth * transfer_us
+ *   callback_us  conversion plus the user callback, shall stay below transfer_us
+ * The _max fields hold the worst case since airspy_start_rx().
+ */
+typedef struct {
+	uint32_t transfer_us;
+	uint32_t queue_us;
+	uint32_t queue_max_us;
+	uint32_t callback_us;
+	uint32_t callback_max_us;
+} airspy_latency_t;
+
+/* Duration of one stage since airspy_start_rx(), in nanoseconds. p99_ns is exact to 12.5% */
+typedef struct {
+	uint64_t count;
+	uint64_t min_ns;
+	uint64_t avg_ns;
+	uint64_t p99_ns;
+	uint64_t max_ns;
+} airspy_stage_timing_t;
+
+#define AIRSPY_HISTOGRAM_BUCKETS 32
+
+/*
+ * Since airspy_start_rx(). buckets[0] counts the zeros, buckets[i] the values from 2^(i-1) to 2^i - 1
+ * and the last bucket everything above. p50 and p99 are exact to 12.5%.
+ */
+typedef struct {
+	uint64_t count;
+	uint64_t max;
+	uint64_t p50;
+	uint64_t p99;
+	uint64_t buckets[AIRSPY_HISTOGRAM_BUCKETS];
+} airspy_histogram_t;
+
+/*
+ * Streaming counters, cumulative since the device was opened and cheap to read while streaming:
+ *   bytes, buffers     USB buffers received
+ *   samples            samples delivered to the callback or to airspy_acquire_block()
+ *   queue_overruns     USB buffers dropped because the consumer was behind, the source of dropped_samples
+ *   pool_overruns      USB buffers dropped because every pool buffer was retained, see airspy_set_buffer_pool()
+ *   queue_high_water   most USB buffers waiting for the consumer at once
+ *   transfer_errors    failed transfers by enum airspy_transfer_error, each one stops the streaming
+ *   resubmit_failures  transfers that could not be submitted again, stops the streaming
+ *   callback_stops     callbacks that returned non zero
+ */
+typedef struct {
+	uint64_t bytes;
+	uint64_t buffers;
+	uint64_t samples;
+	uint64_t queue_overruns;
+	uint64_t pool_overruns;
+	uint64_t queue_high_water;
+	uint64_t transfer_errors[AIRSPY_TRANSFER_ERROR_END];
+	uint64_t resubmit_failures;
+	uint64_t callback_stops;
+} airspy_stats_t;
+
 typedef struct {
 	uint32_t part_id[2];
 	uint32_t serial_no[4];
@@ -117,6 +276,7 @@ typedef struct {
 } airspy_lib_version_t;
 
 typedef int (*airspy_sample_block_cb_fn)(airspy_transfer* transfer);
+typedef void (*airspy_watchdog_cb_fn)(struct airspy_device* device, void* ctx, uint32_t elapsed_us);
 
 extern ADDAPI void ADDCALL airspy_lib_version(airspy_lib_version_t* lib_version);
 /* airspy_init() deprecated */
@@ -131,6 +291,28 @@ extern ADDAPI int ADDCALL airspy_open_fd(struct airspy_device** device, int fd);
 extern ADDAPI int ADDCALL airspy_open(struct airspy_device** device);
 extern ADDAPI int ADDCALL airspy_close(struct airspy_device* device);
 
+/*
+ * Devices opened into a shared context use its libusb context and a single event thread for all their transfers.
+ * Their callbacks run on the DSP pool. Not usable with airspy_set_event_loop(). Close every device before destroying the context.
+ */
+extern ADDAPI int ADDCALL airspy_context_create(struct airspy_context** context);
+extern ADDAPI int ADDCALL airspy_context_destroy(struct airspy_context* context);
+/* serial_number: 0 for the first available device */
+extern ADDAPI int ADDCALL airspy_open_context(struct airspy_context* context, struct airspy_device** device, uint64_t serial_number);
+
+/*
+ * Process-wide pool of threads running the callbacks, and so the conversion, of all the devices using it: devices
+ * opened into a context and those with airspy_set_shared_dsp(). A device is processed by one thread at a time, one
+ * USB buffer after the other, so its callbacks never run concurrently and its samples stay in order. Idle threads
+ * take over the buffers of busy devices, so the cores get shared according to the actual load.
+ * thread_count: up to 64, 0 (default) for one per core. cpus: cpu_count CPUs the threads get pinned to, round robin,
+ * NULL for none. priority: 1 to 99 for SCHED_FIFO (THREAD_PRIORITY_TIME_CRITICAL on Windows), 0 for the default.
+ * Applies once the pool restarts, AIRSPY_ERROR_BUSY while a device streams with it.
+ */
+extern ADDAPI int ADDCALL airspy_set_dsp_pool(uint32_t thread_count, const int* cpus, uint32_t cpu_count, int priority);
+/* To be set before airspy_start_rx(): the callback runs on the DSP pool rather than a consumer thread of the device */
+extern ADDAPI int ADDCALL airspy_set_shared_dsp(struct airspy_device* device, uint8_t value);
+
 /* Use airspy_get_samplerates(device, buffer, 0) to get the number of available sample rates. It will be returned in the first element of buffer */
 extern ADDAPI int ADDCALL airspy_get_samplerates(struct airspy_device* device, uint32_t* buffer, const uint32_t len);
 
@@ -140,9 +322,107 @@ extern ADDAPI int ADDCALL airspy_set_samplerate(struct airspy_device* device, ui
 extern ADDAPI int ADDCALL airspy_set_conversion_filter_float32(struct airspy_device* device, const float *kernel, const uint32_t len);
 extern ADDAPI int ADDCALL airspy_set_conversion_filter_int16(struct airspy_device* device, const int16_t *kernel, const uint32_t len);
 
+/* Parameter count shall be between 1 (default) and 16, the IQ conversion of each buffer is shared by that many threads.
+   The output is identical to the single threaded conversion. */
+extern ADDAPI int ADDCALL airspy_set_conversion_threads(struct airspy_device* device, uint32_t count);
+
+extern ADDAPI int ADDCALL airspy_set_wait_strategy(struct airspy_device* device, enum airspy_wait_strategy strategy);
+
+/* Buffering, to be set before airspy_start_rx(). Changing any of these drops the buffered samples.
+   count: USB transfers in flight, 1 to 64 (default 16).
+   size: bytes per transfer up to 4 MiB, rounded down to a multiple of 512 (1536 when packed). 0 restores the default of 262144 (147456 when packed).
+   depth: buffers queued between the USB thread and the callback, 1 to 256 (default 8). */
+extern ADDAPI int ADDCALL airspy_set_transfer_count(struct airspy_device* device, uint32_t count);
+extern ADDAPI int ADDCALL airspy_set_transfer_size(struct airspy_device* device, uint32_t size);
+extern ADDAPI int ADDCALL airspy_get_transfer_size(struct airspy_device* device, uint32_t* size);
+extern ADDAPI int ADDCALL airspy_set_queue_depth(struct airspy_device* device, uint32_t depth);
+/* Current queue depth, including the buffers added by auto-tuning */
+extern ADDAPI int ADDCALL airspy_get_queue_depth(struct airspy_device* device, uint32_t* depth);
+/* Callbacks get exactly sample_count samples (IQ pairs for the IQ types), whatever the transfer size.
+   0 (default) delivers one callback per USB transfer. Not applied to AIRSPY_SAMPLE_RAW. Up to 20000000 samples.
+   Samples are converted in place into the block being filled, only the partial block left after a transfer is moved. */
+extern ADDAPI int ADDCALL airspy_set_callback_block_size(struct airspy_device* device, uint32_t sample_count);
+/*
+ * Pool of output buffers, to be set before airspy_start_rx(). A callback may airspy_buffer_retain() the samples it got
+ * (transfer->samples, or any block within it) and airspy_buffer_release() them later from any thread: the library
+ * converts into another pool buffer meanwhile, and waits for a release when all of them are held.
+ * Only the consumer thread waits. With airspy_set_inline_conversion(), airspy_set_event_loop() or the DSP pool,
+ * the USB buffer is dropped instead, counted in dropped_samples and airspy_stats_t.pool_overruns. In pull mode,
+ * airspy_acquire_block() returns AIRSPY_ERROR_BUSY and leaves the USB buffer queued.
+ * count: 1 (default, no retaining) to 256. RAW and unpacked UINT16_REAL samples get copied into the pool when count > 1.
+ * memory: NULL to let the library allocate, or size bytes owned by the application, at least what
+ * airspy_get_buffer_pool_size() returns once the other buffering settings are made.
+ * Release every buffer before changing the buffering settings or closing the device.
+ */
+extern ADDAPI int ADDCALL airspy_set_buffer_pool(struct airspy_device* device, uint32_t count, void* memory, size_t size);
+extern ADDAPI int ADDCALL airspy_get_buffer_pool_size(struct airspy_device* device, uint32_t count, size_t* size);
+extern ADDAPI int ADDCALL airspy_buffer_retain(struct airspy_device* device, void* samples);
+extern ADDAPI int ADDCALL airspy_buffer_release(struct airspy_device* device, void* samples);
+/* The transfers, queued buffers and library allocated pool share one mapping per device, 64 byte aligned and faulted in
+   at allocation. flags: airspy_memory_flags, numa_node: node the memory is preferably placed on, -1 (default) for any,
+   AIRSPY_NUMA_THREAD_NODE to follow airspy_set_thread_scheduling().
+   Both are best effort, airspy_get_memory_options() returns the flags actually obtained.
+   Where the kernel supports it, the transfers and queued buffers are mapped from usbfs instead, see AIRSPY_MEMORY_ZERO_COPY. */
+extern ADDAPI int ADDCALL airspy_set_memory_options(struct airspy_device* device, uint32_t flags, int numa_node);
+extern ADDAPI int ADDCALL airspy_get_memory_options(struct airspy_device* device, uint32_t* flags);
+/* To be set before airspy_start_rx(), applied by each thread as it starts. cpu_mask: CPUs 0 to 63 the thread may run on,
+   0 (default) for any. priority: 1 to 99 with AIRSPY_SCHED_FIFO / AIRSPY_SCHED_RR, which need CAP_SYS_NICE or an
+   RLIMIT_RTPRIO allowance on Linux. Best effort. Threads of the DSP pool and of a context follow airspy_set_dsp_pool() instead. */
+extern ADDAPI int ADDCALL airspy_set_thread_scheduling(struct airspy_device* device, enum airspy_thread thread, uint64_t cpu_mask, enum airspy_sched_policy policy, int priority);
+/* Enabled: 32 transfers of 16 KiB, 4 queued buffers and AIRSPY_WAIT_SPIN_THEN_BLOCK, about 0.4 ms per callback at 10 MSPS.
+   Disabled: restores the default buffering and wait strategy. Converter state carries over from one block to the next either way. */
+extern ADDAPI int ADDCALL airspy_set_low_latency(struct airspy_device* device, uint8_t value);
+extern ADDAPI int ADDCALL airspy_get_latency(struct airspy_device* device, airspy_latency_t* latency);
+extern ADDAPI int ADDCALL airspy_get_stats(struct airspy_device* device, airspy_stats_t* stats);
+/* Times each stage of every buffer, off by default. Costs two clock reads per stage when on, a test when off */
+extern ADDAPI int ADDCALL airspy_set_stage_timing(struct airspy_device* device, uint8_t value);
+extern ADDAPI int ADDCALL airspy_get_stage_timing(struct airspy_device* device, enum airspy_stage stage, airspy_stage_timing_t* timing);
+extern ADDAPI int ADDCALL airspy_get_histogram(struct airspy_device* device, enum airspy_histogram which, airspy_histogram_t* histogram);
+/*
+ * Calls watchdog once for each call of the sample callback running longer than budget_us: from the USB
+ * thread while the callback still runs, else from the callback's thread right after it returned.
+ * The watchdog shall return quickly. NULL disables it.
+ */
+extern ADDAPI int ADDCALL airspy_set_callback_watchdog(struct airspy_device* device, uint32_t budget_us, airspy_watchdog_cb_fn watchdog, void* ctx);
+/* When enabled, the queue grows instead of dropping a buffer, up to 256 buffers or 64 MiB. The grown depth is kept across restarts */
+extern ADDAPI int ADDCALL airspy_set_buffer_auto_tune(struct airspy_device* device, uint8_t value);
+
 extern ADDAPI int ADDCALL airspy_start_rx(struct airspy_device* device, airspy_sample_block_cb_fn callback, void* rx_ctx);
 extern ADDAPI int ADDCALL airspy_stop_rx(struct airspy_device* device);
 
+/*
+ * Pull mode, started with airspy_start_rx(device, NULL, ctx): no consumer thread is created and the
+ * application reads the samples from a single thread of its own. Samples are converted on that thread
+ * straight out of the USB buffers. timeout_ms: 0 returns immediately, -1 waits without a timeout.
+ * Call airspy_stop_rx() from the reading thread or once it no longer reads.
+ */
+/* Converted samples of the next USB buffer, valid until airspy_release_block(). AIRSPY_ERROR_TIMEOUT when none arrived in time, AIRSPY_ERROR_BUSY while every pool buffer is retained */
+extern ADDAPI int ADDCALL airspy_acquire_block(struct airspy_device* device, airspy_transfer_t* transfer, int timeout_ms);
+extern ADDAPI int ADDCALL airspy_release_block(struct airspy_device* device);
+/* Copies sample_count samples (IQ pairs for the IQ types) into buffer. Returns the count copied, short of sample_count
+   when timeout_ms expired, or a negative airspy_error once streaming stopped. Not to be mixed with airspy_acquire_block().
+   Pull mode ignores the callback block size, airspy_read_samples() takes any count. */
+extern ADDAPI int ADDCALL airspy_read_samples(struct airspy_device* device, void* buffer, uint32_t sample_count, int timeout_ms);
+
+/*
+ * Event loop mode, to be set before airspy_start_rx(), not available on Windows. The library starts no
+ * thread of its own (except for airspy_set_conversion_threads() > 1): poll the descriptors returned by
+ * airspy_get_pollfds() and call airspy_process_events() whenever one is ready. With a callback, the
+ * callback runs from airspy_process_events(). In pull mode, the last descriptor polls readable while
+ * samples are waiting for airspy_acquire_block() / airspy_read_samples() with a timeout of 0.
+ * Transfers have no timeout, so there are no libusb timeouts to drive.
+ */
+extern ADDAPI int ADDCALL airspy_set_event_loop(struct airspy_device* device, uint8_t value);
+/* Fills up to len descriptors, libusb's followed by the sample event descriptor. count receives the total */
+extern ADDAPI int ADDCALL airspy_get_pollfds(struct airspy_device* device, airspy_pollfd_t* fds, uint32_t len, uint32_t* count);
+/* Never blocks. AIRSPY_ERROR_STREAMING_STOPPED once a callback asked to stop or the USB transfers failed */
+extern ADDAPI int ADDCALL airspy_process_events(struct airspy_device* device);
+
+/* Converts and runs the callback right in the USB completion, before the transfer is resubmitted, instead of on the consumer
+   thread. Saves a thread and a wakeup per buffer for light callbacks, a slow one stalls USB events and the device overflows
+   once every transfer is waiting. Dropped samples are no longer reported. Ignored in pull mode. Set before airspy_start_rx() */
+extern ADDAPI int ADDCALL airspy_set_inline_conversion(struct airspy_device* device, uint8_t value);
+
 /* return AIRSPY_TRUE if success */
 extern ADDAPI int ADDCALL airspy_is_streaming(struct airspy_device* device);
 
@@ -217,6 +497,12 @@ extern ADDAPI const char* ADDCALL airspy_board_id_name(enum airspy_board_id boar
 /* Parameter sector_num shall be between 2 & 13 (sector 0 & 1 are reserved) */
 extern ADDAPI int ADDCALL airspy_spiflash_erase_sector(struct airspy_device* device, const uint16_t sector_num);
 
+/* Returns the enum airspy_cpu_feature bits detected on the host CPU */
+extern ADDAPI uint32_t ADDCALL airspy_get_cpu_features(void);
+/* Returns the implementation bound to a DSP kernel for the current sample type and filter, e.g. "scalar", "sse2" or "avx2" */
+extern ADDAPI const char* ADDCALL airspy_get_dsp_kernel_variant(struct airspy_device* device, enum airspy_dsp_kernel kernel);
+extern ADDAPI const char* ADDCALL airspy_dsp_kernel_name(enum airspy_dsp_kernel kernel);
+
 #ifdef __cplusplus
 } // __cplusplus defined.
 #endif
@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+#if defined(__linux__)
+#define ARENA_MPOL_PREFERRED 1
+#define ARENA_MAX_NODES 1024
+
+// mbind() without depending on libnuma, the policy shall be set before the pages get faulted in
+static void bind_node(void *p, size_t size, int numa_node)
+{
+	unsigned long mask[ARENA_MAX_NODES / (8 * sizeof(unsigned long))];
+
+	if (numa_node < 0 || numa_node >= ARENA_MAX_NODES)
+	{
+		return;
+	}
+
+	memset(mask, 0, sizeof(mask));
+	mask[numa_node / (8 * sizeof(unsigned long))] = 1UL << (numa_node % (8 * sizeof(unsigned long)));
+
+	syscall(SYS_mbind, p, size, ARENA_MPOL_PREFERRED, mask, (unsigned long) ARENA_MAX_NODES + 1, 0);
+}
+#endif
+
+#if defined(_WIN32)
+static void *map_memory(size_t *size, uint32_t *flags, int numa_node)
+{
+	void *p = NULL;
+	size_t large_page = GetLargePageMinimum();
+	size_t large_size;
+	DWORD node = numa_node < 0 ? NUMA_NO_PREFERRED_NODE : (DWORD) numa_node;
+
+	// Large pages need SeLockMemoryPrivilege, and are never paged out
+	if ((*flags & ARENA_HUGEPAGES) && large_page != 0)
+	{
+		large_size = (*size + large_page - 1) & ~(large_page - 1);
+		p = VirtualAllocExNuma(GetCurrentProcess(), NULL, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, node);
+		if (p != NULL)
+		{
+			*size = large_size;
+			*flags |= ARENA_LOCKED;
+			return p;
+		}
+	}
+
+	*flags &= ~ARENA_HUGEPAGES;
+	return VirtualAllocExNuma(GetCurrentProcess(), NULL, *size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+}
+
+static void unmap_memory(void *p, size_t size)
+{
+	(void) size;
+	VirtualFree(p, 0, MEM_RELEASE);
+}
+
+static int lock_memory(void *p, size_t size)
+{
+	SIZE_T min_size;
+	SIZE_T max_size;
+
+	// The working set has to make room for the locked pages
+	if (GetProcessWorkingSetSize(GetCurrentProcess(), &min_size, &max_size))
+	{
+		SetProcessWorkingSetSize(GetCurrentProcess(), min_size + size, max_size + size);
+	}
+
+	return VirtualLock(p, size) ? 0 : -1;
+}
+#else
+static void *map_memory(size_t *size, uint32_t *flags, int numa_node)
+{
+	void *p = MAP_FAILED;
+	size_t huge_size = (*size + HUGEPAGE_SIZE - 1) & ~(size_t) (HUGEPAGE_SIZE - 1);
+
+#if defined(MAP_HUGETLB)
+	// Reserved hugepages first, transparent hugepages otherwise
+	if (*flags & ARENA_HUGEPAGES)
+	{
+		p = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+#endif
+
+	if (p != MAP_FAILED)
+	{
+		*size = huge_size;
+	}
+	else
+	{
+		*flags &= ~ARENA_HUGEPAGES;
+		p = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+		{
+			return NULL;
+		}
+	}
+
+#if defined(MADV_HUGEPAGE)
+	if (!(*flags & ARENA_HUGEPAGES) && *size >= HUGEPAGE_SIZE)
+	{
+		madvise(p, *size, MADV_HUGEPAGE);
+	}
+#endif
+
+#if defined(__linux__)
+	bind_node(p, *size, numa_node);
+#else
+	(void) numa_node;
+#endif
+
+	return p;
+}
+
+static void unmap_memory(void *p, size_t size)
+{
+	munmap(p, size);
+}
+
+static int lock_memory(void *p, size_t size)
+{
+	return mlock(p, size);
+}
+#endif
+
+size_t arena_block_size(size_t size)
+{
+	return (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+}
+
+int arena_init(arena_t *arena, size_t size, uint32_t flags, int numa_node)
+{
+	memset(arena, 0, sizeof(arena_t));
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	arena->size = size;
+	arena->flags = flags & ARENA_HUGEPAGES;
+	arena->base = (uint8_t *) map_memory(&arena->size, &arena->flags, numa_node);
+	if (arena->base == NULL)
+	{
+		arena->size = 0;
+		return -1;
+	}
+
+	if ((flags & ARENA_LOCKED) && !(arena->flags & ARENA_LOCKED) && lock_memory(arena->base, arena->size) == 0)
+	{
+		arena->flags |= ARENA_LOCKED;
+	}
+
+	// Faults every page in now rather than on the first transfers
+	memset(arena->base, 0, arena->size);
+
+	return 0;
+}
+
+void arena_attach(arena_t *arena, void *memory, size_t size)
+{
+	memset(arena, 0, sizeof(arena_t));
+	arena->base = (uint8_t *) memory;
+	arena->size = size;
+	arena->external = 1;
+}
+
+void arena_free(arena_t *arena)
+{
+	if (arena->base != NULL && !arena->external)
+	{
+		unmap_memory(arena->base, arena->size);
+	}
+
+	memset(arena, 0, sizeof(arena_t));
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+	void *p;
+
+	size = arena_block_size(size);
+	if (arena->base == NULL || arena->size - arena->used < size)
+	{
+		return NULL;
+	}
+
+	p = arena->base + arena->used;
+	arena->used += size;
+
+	return p;
+}
+
+void arena_release(const arena_t *arena, void *p)
+{
+	const uint8_t *b = (const uint8_t *) p;
+
+	if (arena->base != NULL && b >= arena->base && b < arena->base + arena->size)
+	{
+		return;
+	}
+
+	free(p);
+}
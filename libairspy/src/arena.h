@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 64
+
+/* Same values as enum airspy_memory_flags */
+#define ARENA_HUGEPAGES (1 << 0)
+#define ARENA_LOCKED (1 << 1)
+
+#define ARENA_ANY_NODE (-1)
+
+/*
+ * One contiguous mapping per device that the streaming buffers are carved
+ * from, ARENA_ALIGNMENT aligned. Pages are faulted in (and locked when
+ * asked) up front, so that streaming does not page fault.
+ * Hugepages, locking and NUMA placement are best effort, flags tells what
+ * was obtained.
+ */
+typedef struct {
+	uint8_t *base;
+	size_t size;
+	size_t used;
+	uint32_t flags;
+	int external;
+} arena_t;
+
+int arena_init(arena_t *arena, size_t size, uint32_t flags, int numa_node);
+/* Carves from memory owned by the caller instead, left alone by arena_free() */
+void arena_attach(arena_t *arena, void *memory, size_t size);
+void arena_free(arena_t *arena);
+
+/* Bump allocation, not thread safe. NULL once the arena is exhausted */
+void *arena_alloc(arena_t *arena, size_t size);
+/* Memory from arena_alloc() needs no release, anything else goes back to the heap */
+void arena_release(const arena_t *arena, void *p);
+
+/* Size taken by arena_alloc(size) */
+size_t arena_block_size(size_t size);
+
+#endif // ARENA_H
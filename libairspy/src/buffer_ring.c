@@ -0,0 +1,391 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "buffer_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif !defined(_MSC_VER)
+#include <sys/time.h>
+#endif
+
+// Pause iterations before BUFFER_RING_WAIT_SPIN_THEN_BLOCK goes to sleep, a few tens of microseconds
+#define SPIN_COUNT 2000
+
+#if defined(_MSC_VER)
+	// Volatile accesses have acquire / release semantics with /volatile:ms, the default on x86
+	#define LOAD_ACQUIRE(p) (*(p))
+	#define STORE_RELEASE(p, v) (*(p) = (v))
+	#define FULL_FENCE() MemoryBarrier()
+	#define CPU_RELAX() YieldProcessor()
+#else
+	#define LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+	#define STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+	#define FULL_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+	#if defined(__x86_64__) || defined(__i386__)
+		#define CPU_RELAX() __builtin_ia32_pause()
+	#elif defined(__aarch64__) || defined(__arm__)
+		#define CPU_RELAX() __asm__ __volatile__("yield")
+	#else
+		#define CPU_RELAX() do { } while (0)
+	#endif
+#endif
+
+static uint32_t next_position(const buffer_ring_t *ring, uint32_t position)
+{
+	return position + 1 == ring->slots ? 0 : position + 1;
+}
+
+static void *allocate_buffer(buffer_ring_t *ring)
+{
+	void *buffer = NULL;
+
+	if (ring->arena != NULL)
+	{
+		buffer = arena_alloc(ring->arena, ring->buffer_size);
+	}
+
+	return buffer != NULL ? buffer : malloc(ring->buffer_size);
+}
+
+static void free_buffer(buffer_ring_t *ring, void *buffer)
+{
+	if (ring->arena != NULL)
+	{
+		arena_release(ring->arena, buffer);
+	}
+	else
+	{
+		free(buffer);
+	}
+}
+
+// The free and filled queues never hold more than max_count buffers, one spare slot tells full from empty
+int buffer_ring_init(buffer_ring_t *ring, uint32_t count, uint32_t max_count, size_t buffer_size, arena_t *arena)
+{
+	uint32_t i;
+
+	memset(ring, 0, sizeof(buffer_ring_t));
+	ring->slots = max_count + 1;
+	ring->buffer_size = buffer_size;
+	ring->arena = arena;
+
+	pthread_mutex_init(&ring->mp, NULL);
+	pthread_cond_init(&ring->cv, NULL);
+
+	ring->entries = (buffer_ring_entry_t *) calloc(ring->slots, sizeof(buffer_ring_entry_t));
+	ring->free_buffers = (void **) calloc(ring->slots, sizeof(void *));
+	if (ring->entries == NULL || ring->free_buffers == NULL)
+	{
+		buffer_ring_free(ring);
+		return -1;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		ring->free_buffers[i] = allocate_buffer(ring);
+		if (ring->free_buffers[i] == NULL)
+		{
+			buffer_ring_free(ring);
+			return -1;
+		}
+		memset(ring->free_buffers[i], 0, buffer_size);
+
+		ring->free_head = i + 1;
+		ring->count = i + 1;
+	}
+
+	return 0;
+}
+
+void buffer_ring_free(buffer_ring_t *ring)
+{
+	uint32_t position;
+
+	if (ring->entries != NULL && ring->free_buffers != NULL)
+	{
+		for (position = ring->tail; position != ring->head; position = next_position(ring, position))
+		{
+			free_buffer(ring, ring->entries[position].buffer);
+		}
+		for (position = ring->free_tail; position != ring->free_head; position = next_position(ring, position))
+		{
+			free_buffer(ring, ring->free_buffers[position]);
+		}
+	}
+
+	free(ring->entries);
+	free(ring->free_buffers);
+	ring->entries = NULL;
+	ring->free_buffers = NULL;
+
+	pthread_cond_destroy(&ring->cv);
+	pthread_mutex_destroy(&ring->mp);
+}
+
+void buffer_ring_reset(buffer_ring_t *ring, int wait_strategy, uint32_t grow_limit)
+{
+	while (ring->tail != ring->head)
+	{
+		ring->free_buffers[ring->free_head] = ring->entries[ring->tail].buffer;
+		ring->free_head = next_position(ring, ring->free_head);
+		ring->tail = next_position(ring, ring->tail);
+	}
+
+	ring->dropped = 0;
+	ring->sleeping = 0;
+	ring->closed = 0;
+	ring->wait_strategy = wait_strategy;
+	ring->grow_limit = grow_limit < ring->slots - 1 ? grow_limit : ring->slots - 1;
+}
+
+/* The futex deadline is on the monotonic clock, pthread_cond_timedwait() uses the realtime clock */
+static void get_time(struct timespec *now)
+{
+#if defined(__linux__)
+	clock_gettime(CLOCK_MONOTONIC, now);
+#elif defined(_MSC_VER)
+	timespec_get(now, TIME_UTC);
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	now->tv_sec = tv.tv_sec;
+	now->tv_nsec = tv.tv_usec * 1000;
+#endif
+}
+
+static void get_deadline(struct timespec *deadline, int timeout_ms)
+{
+	get_time(deadline);
+	deadline->tv_sec += timeout_ms / 1000;
+	deadline->tv_nsec += (long) (timeout_ms % 1000) * 1000000;
+	if (deadline->tv_nsec >= 1000000000)
+	{
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+static int deadline_passed(const struct timespec *deadline)
+{
+	struct timespec now;
+
+	get_time(&now);
+
+	return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+/*
+ * The sleeper publishes sleeping then reads head, the waker publishes head
+ * (or closed) then reads sleeping. With a full fence on both sides at least
+ * one of them sees the other's store, so a wakeup is never lost.
+ */
+static void wake_consumer(buffer_ring_t *ring)
+{
+	FULL_FENCE();
+	if (!ring->sleeping)
+	{
+		return;
+	}
+
+#if defined(__linux__)
+	__atomic_add_fetch(&ring->wake_seq, 1, __ATOMIC_SEQ_CST);
+	syscall(SYS_futex, &ring->wake_seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+	pthread_mutex_lock(&ring->mp);
+	pthread_cond_signal(&ring->cv);
+	pthread_mutex_unlock(&ring->mp);
+#endif
+}
+
+// deadline is NULL to wait without a timeout
+static void sleep_consumer(buffer_ring_t *ring, uint32_t tail, const struct timespec *deadline)
+{
+#if defined(__linux__)
+	uint32_t seq = LOAD_ACQUIRE(&ring->wake_seq);
+
+	ring->sleeping = 1;
+	FULL_FENCE();
+	if (LOAD_ACQUIRE(&ring->head) == tail && !ring->closed)
+	{
+		// Returns right away if a wakeup bumped wake_seq in the meantime, the deadline is absolute
+		syscall(SYS_futex, &ring->wake_seq, FUTEX_WAIT_BITSET_PRIVATE, seq, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+	}
+	ring->sleeping = 0;
+#else
+	pthread_mutex_lock(&ring->mp);
+	ring->sleeping = 1;
+	FULL_FENCE();
+	while (LOAD_ACQUIRE(&ring->head) == tail && !ring->closed)
+	{
+		if (deadline == NULL)
+		{
+			pthread_cond_wait(&ring->cv, &ring->mp);
+		}
+		else if (pthread_cond_timedwait(&ring->cv, &ring->mp, deadline) == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	ring->sleeping = 0;
+	pthread_mutex_unlock(&ring->mp);
+#endif
+}
+
+int buffer_ring_push(buffer_ring_t *ring, void **buffer, uint64_t timestamp)
+{
+	void *spare;
+	uint32_t head = ring->head;
+	uint32_t free_tail = ring->free_tail;
+
+	if (free_tail != LOAD_ACQUIRE(&ring->free_head))
+	{
+		spare = ring->free_buffers[free_tail];
+		STORE_RELEASE(&ring->free_tail, next_position(ring, free_tail));
+	}
+	else if (ring->count < ring->grow_limit && (spare = allocate_buffer(ring)) != NULL)
+	{
+		ring->count++;
+	}
+	else
+	{
+		ring->dropped++;
+		return 0;
+	}
+
+	ring->entries[head].buffer = *buffer;
+	ring->entries[head].dropped = ring->dropped;
+	ring->entries[head].timestamp = timestamp;
+	ring->dropped = 0;
+	*buffer = spare;
+
+	STORE_RELEASE(&ring->head, next_position(ring, head));
+
+	if (ring->wait_strategy != BUFFER_RING_WAIT_SPIN)
+	{
+		wake_consumer(ring);
+	}
+
+	return 1;
+}
+
+uint32_t buffer_ring_depth(buffer_ring_t *ring)
+{
+	uint32_t head = ring->head;
+	uint32_t tail = LOAD_ACQUIRE(&ring->tail);
+
+	return head >= tail ? head - tail : head + ring->slots - tail;
+}
+
+void *buffer_ring_acquire(buffer_ring_t *ring, uint32_t *dropped, uint64_t *timestamp, int timeout_ms)
+{
+	unsigned int spins = 0;
+	int spinning;
+	int has_deadline = 0;
+	struct timespec deadline;
+	uint32_t tail = ring->tail;
+
+	while (LOAD_ACQUIRE(&ring->head) == tail)
+	{
+		if (ring->closed || timeout_ms == 0)
+		{
+			return NULL;
+		}
+
+		spinning = ring->wait_strategy == BUFFER_RING_WAIT_SPIN
+			|| (ring->wait_strategy == BUFFER_RING_WAIT_SPIN_THEN_BLOCK && spins < SPIN_COUNT);
+
+		if (timeout_ms > 0)
+		{
+			if (!has_deadline)
+			{
+				get_deadline(&deadline, timeout_ms);
+				has_deadline = 1;
+			}
+			// Spinning reads the clock every 256 pauses only
+			else if ((!spinning || (spins & 255) == 0) && deadline_passed(&deadline))
+			{
+				return NULL;
+			}
+		}
+
+		if (spinning)
+		{
+			CPU_RELAX();
+			spins++;
+		}
+		else
+		{
+			sleep_consumer(ring, tail, has_deadline ? &deadline : NULL);
+		}
+	}
+
+	if (ring->closed)
+	{
+		return NULL;
+	}
+
+	*dropped = ring->entries[tail].dropped;
+	*timestamp = ring->entries[tail].timestamp;
+
+	return ring->entries[tail].buffer;
+}
+
+void buffer_ring_release(buffer_ring_t *ring)
+{
+	uint32_t tail = ring->tail;
+	uint32_t free_head = ring->free_head;
+
+	ring->free_buffers[free_head] = ring->entries[tail].buffer;
+	STORE_RELEASE(&ring->free_head, next_position(ring, free_head));
+	STORE_RELEASE(&ring->tail, next_position(ring, tail));
+}
+
+int buffer_ring_pending(buffer_ring_t *ring)
+{
+	return LOAD_ACQUIRE(&ring->head) != ring->tail;
+}
+
+void buffer_ring_close(buffer_ring_t *ring)
+{
+	ring->closed = 1;
+
+#if defined(__linux__)
+	FULL_FENCE();
+	__atomic_add_fetch(&ring->wake_seq, 1, __ATOMIC_SEQ_CST);
+	syscall(SYS_futex, &ring->wake_seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+	pthread_mutex_lock(&ring->mp);
+	pthread_cond_broadcast(&ring->cv);
+	pthread_mutex_unlock(&ring->mp);
+#endif
+}
@@ -0,0 +1,112 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef BUFFER_RING_H
+#define BUFFER_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "arena.h"
+
+#if _MSC_VER > 1700 && !defined(HAVE_STRUCT_TIMESPEC)
+#define HAVE_STRUCT_TIMESPEC
+#endif
+
+#include <pthread.h>
+
+#define BUFFER_RING_CACHE_LINE 64
+
+/* Same values as enum airspy_wait_strategy */
+#define BUFFER_RING_WAIT_BLOCK 0
+#define BUFFER_RING_WAIT_SPIN 1
+#define BUFFER_RING_WAIT_SPIN_THEN_BLOCK 2
+
+#define BUFFER_RING_INFINITE (-1)
+
+/*
+ * Single producer / single consumer queue of sample buffers. The producer
+ * swaps a filled buffer with one taken from the free queue, the consumer
+ * processes the buffer at the tail in place and returns it to the free
+ * queue once done. Both queues are SPSC in opposite directions, so the
+ * producer may also add buffers on the fly (grow) without any lock.
+ *
+ * Each side writes only to its own cache line. The sleeping flag and the
+ * wake sequence let the producer skip the wakeup entirely while the
+ * consumer is running or spinning.
+ */
+typedef struct {
+	void *buffer;
+	uint32_t dropped;
+	uint64_t timestamp;
+} buffer_ring_entry_t;
+
+typedef struct {
+	uint8_t pad0[BUFFER_RING_CACHE_LINE];
+
+	// Written by the producer
+	volatile uint32_t head;
+	volatile uint32_t free_tail;
+	volatile uint32_t wake_seq;
+	volatile uint32_t count;
+	uint32_t dropped;
+	uint8_t pad1[BUFFER_RING_CACHE_LINE - 5 * sizeof(uint32_t)];
+
+	// Written by the consumer
+	volatile uint32_t tail;
+	volatile uint32_t free_head;
+	volatile uint32_t sleeping;
+	uint8_t pad2[BUFFER_RING_CACHE_LINE - 3 * sizeof(uint32_t)];
+
+	volatile uint32_t closed;
+	int wait_strategy;
+	uint32_t grow_limit;
+	uint32_t slots;
+	size_t buffer_size;
+	arena_t *arena;
+	buffer_ring_entry_t *entries;
+	void **free_buffers;
+	pthread_mutex_t mp;
+	pthread_cond_t cv;
+	uint8_t pad3[BUFFER_RING_CACHE_LINE];
+} buffer_ring_t;
+
+/* Allocates count buffers, the ring may hold up to max_count. Buffers come from arena while it has room, NULL for the heap. Frees everything on failure */
+int buffer_ring_init(buffer_ring_t *ring, uint32_t count, uint32_t max_count, size_t buffer_size, arena_t *arena);
+void buffer_ring_free(buffer_ring_t *ring);
+/* Returns every buffer to the free queue. Up to grow_limit buffers get allocated instead of dropping */
+void buffer_ring_reset(buffer_ring_t *ring, int wait_strategy, uint32_t grow_limit);
+
+/* Producer: swaps *buffer with a free buffer, returns 0 and counts a drop when none is left */
+int buffer_ring_push(buffer_ring_t *ring, void **buffer, uint64_t timestamp);
+
+/* Producer: buffers waiting for the consumer */
+uint32_t buffer_ring_depth(buffer_ring_t *ring);
+
+/* Consumer: waits up to timeout_ms for the next buffer, NULL on timeout or once closed. dropped receives the drops counted before it */
+void *buffer_ring_acquire(buffer_ring_t *ring, uint32_t *dropped, uint64_t *timestamp, int timeout_ms);
+void buffer_ring_release(buffer_ring_t *ring);
+/* Consumer: whether a buffer is waiting */
+int buffer_ring_pending(buffer_ring_t *ring);
+
+/* Wakes the consumer for good */
+void buffer_ring_close(buffer_ring_t *ring);
+
+#endif // BUFFER_RING_H
@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cpu_features.h"
+
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(CPU_FEATURES_X86) && defined(_MSC_VER)
+
+static uint32_t detect_x86(void)
+{
+	int regs[4];
+	int max_leaf;
+	unsigned long long xcr0 = 0;
+	uint32_t features = 0;
+
+	__cpuid(regs, 0);
+	max_leaf = regs[0];
+
+	__cpuid(regs, 1);
+	if (regs[3] & (1 << 26))
+	{
+		features |= CPU_FEATURE_SSE2;
+	}
+	if (regs[2] & (1 << 9))
+	{
+		features |= CPU_FEATURE_SSSE3;
+	}
+	if (regs[2] & (1 << 19))
+	{
+		features |= CPU_FEATURE_SSE41;
+	}
+
+	// The AVX register state must be enabled by the OS
+	if (regs[2] & (1 << 27))
+	{
+		xcr0 = _xgetbv(0);
+	}
+
+	if ((xcr0 & 0x6) == 0x6)
+	{
+		if (regs[2] & (1 << 12))
+		{
+			features |= CPU_FEATURE_FMA;
+		}
+
+		if (max_leaf >= 7)
+		{
+			__cpuidex(regs, 7, 0);
+			if (regs[1] & (1 << 5))
+			{
+				features |= CPU_FEATURE_AVX2;
+			}
+			if ((xcr0 & 0xe0) == 0xe0)
+			{
+				if (regs[1] & (1 << 16))
+				{
+					features |= CPU_FEATURE_AVX512F;
+				}
+				if (regs[1] & (1 << 30))
+				{
+					features |= CPU_FEATURE_AVX512BW;
+				}
+			}
+		}
+	}
+
+	return features;
+}
+
+#elif defined(CPU_FEATURES_X86) && defined(__GNUC__)
+
+static uint32_t detect_x86(void)
+{
+	uint32_t features = 0;
+
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+	{
+		features |= CPU_FEATURE_SSE2;
+	}
+	if (__builtin_cpu_supports("ssse3"))
+	{
+		features |= CPU_FEATURE_SSSE3;
+	}
+	if (__builtin_cpu_supports("sse4.1"))
+	{
+		features |= CPU_FEATURE_SSE41;
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		features |= CPU_FEATURE_AVX2;
+	}
+	if (__builtin_cpu_supports("fma"))
+	{
+		features |= CPU_FEATURE_FMA;
+	}
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		features |= CPU_FEATURE_AVX512F;
+	}
+	if (__builtin_cpu_supports("avx512bw"))
+	{
+		features |= CPU_FEATURE_AVX512BW;
+	}
+
+	return features;
+}
+
+#endif
+
+uint32_t cpu_features_detect(void)
+{
+	static volatile int detected = 0;
+	static volatile uint32_t features = 0;
+
+	if (!detected)
+	{
+#if defined(CPU_FEATURES_X86) && (defined(_MSC_VER) || defined(__GNUC__))
+		features = detect_x86();
+#endif
+#if !defined(CPU_FEATURES_X86_AVX512)
+		features &= ~(CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW);
+#endif
+		detected = 1;
+	}
+
+	return features;
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define CPU_FEATURES_X86
+	// AVX-512 intrinsics are not available before Visual Studio 2017
+	#if !defined(_MSC_VER) || (_MSC_VER >= 1910)
+		#define CPU_FEATURES_X86_AVX512
+	#endif
+#endif
+
+/*
+ * GCC and Clang only accept SIMD intrinsics in functions compiled for the
+ * matching ISA, so each accelerated kernel is tagged with its target and
+ * selected at runtime. MSVC accepts the intrinsics anywhere.
+ */
+#if defined(CPU_FEATURES_X86) && defined(__GNUC__)
+	#define TARGET_SSE2 __attribute__((target("sse2")))
+	#define TARGET_SSSE3 __attribute__((target("ssse3")))
+	#define TARGET_SSE41 __attribute__((target("sse4.1")))
+	#define TARGET_AVX2 __attribute__((target("avx2")))
+	#define TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+	#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,fma")))
+#else
+	#define TARGET_SSE2
+	#define TARGET_SSSE3
+	#define TARGET_SSE41
+	#define TARGET_AVX2
+	#define TARGET_AVX2_FMA
+	#define TARGET_AVX512
+#endif
+
+/* Same bits as enum airspy_cpu_feature */
+#define CPU_FEATURE_SSE2     (1 << 0)
+#define CPU_FEATURE_SSSE3    (1 << 1)
+#define CPU_FEATURE_SSE41    (1 << 2)
+#define CPU_FEATURE_AVX2     (1 << 3)
+#define CPU_FEATURE_FMA      (1 << 4)
+#define CPU_FEATURE_AVX512F  (1 << 5)
+#define CPU_FEATURE_AVX512BW (1 << 6)
+
+#define CPU_FEATURE_AVX2_FMA (CPU_FEATURE_AVX2 | CPU_FEATURE_FMA)
+#define CPU_FEATURE_AVX512   (CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW | CPU_FEATURE_FMA)
+
+#define CPU_HAS(features, mask) (((features) & (mask)) == (mask))
+
+/* Same order as enum airspy_dsp_kernel */
+typedef enum {
+	DSP_KERNEL_UNPACK = 0,
+	DSP_KERNEL_CONVERT = 1,
+	DSP_KERNEL_REMOVE_DC = 2,
+	DSP_KERNEL_TRANSLATE = 3,
+	DSP_KERNEL_FIR = 4,
+	DSP_KERNEL_DELAY = 5,
+	DSP_KERNEL_COUNT = 6
+} dsp_kernel_t;
+
+uint32_t cpu_features_detect(void);
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,392 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "dsp_pool.h"
+#include "thread_sched.h"
+#include <string.h>
+
+#if defined(_MSC_VER)
+	#include <windows.h>
+	#define ATOMIC_LOAD(p) (*(p))
+	#define ATOMIC_INC(p) InterlockedIncrement((volatile LONG *) (p))
+	#define ATOMIC_DEC(p) InterlockedDecrement((volatile LONG *) (p))
+#else
+	#define ATOMIC_LOAD(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+	#define ATOMIC_INC(p) __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+	#define ATOMIC_DEC(p) __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST)
+#endif
+
+#define TASK_IDLE 0
+#define TASK_QUEUED 1
+#define TASK_RUNNING 2
+
+typedef struct {
+	pthread_t thread;
+	uint32_t index;
+	int sleeping;
+	dsp_task_t *head;
+	dsp_task_t *tail;
+	pthread_mutex_t mp;
+	pthread_cond_t cv;
+} dsp_worker_t;
+
+typedef struct {
+	dsp_worker_t workers[DSP_POOL_MAX_THREADS];
+	uint32_t count;
+	uint32_t users;
+	uint32_t next_home;
+	volatile int stop;
+	// Tasks in all the run queues, each queue being under the lock of its worker
+	volatile long queued;
+	uint32_t thread_count;
+	int cpus[DSP_POOL_MAX_THREADS];
+	uint32_t cpu_count;
+	int priority;
+} dsp_pool_t;
+
+static dsp_pool_t pool;
+static pthread_mutex_t pool_mp = PTHREAD_MUTEX_INITIALIZER;
+
+void dsp_task_init(dsp_task_t *task, dsp_task_fn run, void *arg)
+{
+	memset(task, 0, sizeof(dsp_task_t));
+	task->run = run;
+	task->arg = arg;
+	task->state = TASK_IDLE;
+	pthread_mutex_init(&task->mp, NULL);
+	pthread_cond_init(&task->cv, NULL);
+}
+
+void dsp_task_destroy(dsp_task_t *task)
+{
+	pthread_cond_destroy(&task->cv);
+	pthread_mutex_destroy(&task->mp);
+}
+
+static void push_task(dsp_worker_t *worker, dsp_task_t *task)
+{
+	task->next = NULL;
+	if (worker->tail != NULL)
+	{
+		worker->tail->next = task;
+	}
+	else
+	{
+		worker->head = task;
+	}
+	worker->tail = task;
+	ATOMIC_INC(&pool.queued);
+}
+
+static dsp_task_t *pop_task(dsp_worker_t *worker)
+{
+	dsp_task_t *task;
+
+	pthread_mutex_lock(&worker->mp);
+	task = worker->head;
+	if (task != NULL)
+	{
+		worker->head = task->next;
+		if (worker->head == NULL)
+		{
+			worker->tail = NULL;
+		}
+		ATOMIC_DEC(&pool.queued);
+	}
+	pthread_mutex_unlock(&worker->mp);
+
+	return task;
+}
+
+// Wakes the home worker, or when it is busy any sleeping worker, which will steal the task
+static void enqueue_task(dsp_worker_t *home, dsp_task_t *task)
+{
+	uint32_t i;
+	dsp_worker_t *worker;
+
+	pthread_mutex_lock(&home->mp);
+	push_task(home, task);
+	if (home->sleeping)
+	{
+		pthread_cond_signal(&home->cv);
+		pthread_mutex_unlock(&home->mp);
+		return;
+	}
+	pthread_mutex_unlock(&home->mp);
+
+	for (i = 1; i < pool.count; i++)
+	{
+		worker = &pool.workers[(home->index + i) % pool.count];
+
+		pthread_mutex_lock(&worker->mp);
+		if (worker->sleeping)
+		{
+			pthread_cond_signal(&worker->cv);
+			pthread_mutex_unlock(&worker->mp);
+			return;
+		}
+		pthread_mutex_unlock(&worker->mp);
+	}
+}
+
+static dsp_task_t *steal_task(dsp_worker_t *self)
+{
+	uint32_t i;
+	dsp_task_t *task;
+
+	for (i = 1; i < pool.count; i++)
+	{
+		task = pop_task(&pool.workers[(self->index + i) % pool.count]);
+		if (task != NULL)
+		{
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+static void run_task(dsp_worker_t *self, dsp_task_t *task)
+{
+	int more;
+
+	pthread_mutex_lock(&task->mp);
+	task->state = TASK_RUNNING;
+	task->rerun = 0;
+	pthread_mutex_unlock(&task->mp);
+
+	more = task->run(task->arg);
+
+	pthread_mutex_lock(&task->mp);
+	if (more || task->rerun)
+	{
+		// Back at the end of this worker's queue, so that the other tasks get their turn
+		task->state = TASK_QUEUED;
+		enqueue_task(self, task);
+	}
+	else
+	{
+		task->state = TASK_IDLE;
+		pthread_cond_broadcast(&task->cv);
+	}
+	pthread_mutex_unlock(&task->mp);
+}
+
+static void *worker_threadproc(void *arg)
+{
+	dsp_worker_t *self = (dsp_worker_t *) arg;
+	dsp_task_t *task;
+	thread_sched_t sched;
+	int cpu = pool.cpu_count > 0 ? pool.cpus[self->index % pool.cpu_count] : -1;
+
+	sched.cpu_mask = cpu >= 0 && cpu < 64 ? (uint64_t) 1 << cpu : 0;
+	sched.policy = pool.priority > 0 ? THREAD_SCHED_FIFO : THREAD_SCHED_DEFAULT;
+	sched.priority = pool.priority;
+	thread_sched_apply(&sched);
+
+	while (!pool.stop)
+	{
+		task = pop_task(self);
+		if (task == NULL)
+		{
+			task = steal_task(self);
+		}
+
+		if (task != NULL)
+		{
+			run_task(self, task);
+			continue;
+		}
+
+		// A task queued elsewhere after the steal attempt is seen here, or its worker scan finds this one sleeping
+		pthread_mutex_lock(&self->mp);
+		if (self->head == NULL && ATOMIC_LOAD(&pool.queued) == 0 && !pool.stop)
+		{
+			self->sleeping = 1;
+			pthread_cond_wait(&self->cv, &self->mp);
+			self->sleeping = 0;
+		}
+		pthread_mutex_unlock(&self->mp);
+	}
+
+	pthread_exit(NULL);
+
+	return NULL;
+}
+
+// Joins the first started workers
+static void stop_workers(uint32_t started)
+{
+	uint32_t i;
+	dsp_worker_t *worker;
+
+	pool.stop = 1;
+	for (i = 0; i < started; i++)
+	{
+		worker = &pool.workers[i];
+
+		pthread_mutex_lock(&worker->mp);
+		pthread_cond_signal(&worker->cv);
+		pthread_mutex_unlock(&worker->mp);
+	}
+
+	for (i = 0; i < pool.count; i++)
+	{
+		worker = &pool.workers[i];
+
+		if (i < started)
+		{
+			pthread_join(worker->thread, NULL);
+		}
+		pthread_cond_destroy(&worker->cv);
+		pthread_mutex_destroy(&worker->mp);
+	}
+
+	pool.count = 0;
+}
+
+static int start_workers(void)
+{
+	uint32_t i;
+	uint32_t count;
+	dsp_worker_t *worker;
+
+	count = pool.thread_count != 0 ? pool.thread_count : thread_sched_cpu_count();
+	if (count > DSP_POOL_MAX_THREADS)
+	{
+		count = DSP_POOL_MAX_THREADS;
+	}
+
+	pool.stop = 0;
+	pool.queued = 0;
+	pool.next_home = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		worker = &pool.workers[i];
+		memset(worker, 0, sizeof(dsp_worker_t));
+		worker->index = i;
+		pthread_mutex_init(&worker->mp, NULL);
+		pthread_cond_init(&worker->cv, NULL);
+	}
+
+	// Workers index each other from the start
+	pool.count = count;
+	for (i = 0; i < count; i++)
+	{
+		if (pthread_create(&pool.workers[i].thread, NULL, worker_threadproc, &pool.workers[i]) != 0)
+		{
+			stop_workers(i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int dsp_pool_configure(uint32_t thread_count, const int *cpus, uint32_t cpu_count, int priority)
+{
+	int result = 0;
+
+	if (thread_count > DSP_POOL_MAX_THREADS || cpu_count > DSP_POOL_MAX_THREADS || (cpus == NULL && cpu_count != 0))
+	{
+		return -1;
+	}
+
+	pthread_mutex_lock(&pool_mp);
+	if (pool.users > 0)
+	{
+		result = -1;
+	}
+	else
+	{
+		pool.thread_count = thread_count;
+		pool.cpu_count = cpus != NULL ? cpu_count : 0;
+		if (pool.cpu_count > 0)
+		{
+			memcpy(pool.cpus, cpus, pool.cpu_count * sizeof(int));
+		}
+		pool.priority = priority;
+	}
+	pthread_mutex_unlock(&pool_mp);
+
+	return result;
+}
+
+int dsp_pool_attach(dsp_task_t *task)
+{
+	int result = 0;
+
+	pthread_mutex_lock(&pool_mp);
+	if (pool.users == 0)
+	{
+		result = start_workers();
+	}
+
+	if (result == 0)
+	{
+		pool.users++;
+		task->home = pool.next_home++ % pool.count;
+		task->state = TASK_IDLE;
+		task->rerun = 0;
+	}
+	pthread_mutex_unlock(&pool_mp);
+
+	return result;
+}
+
+// The task shall be idle
+void dsp_pool_detach(dsp_task_t *task)
+{
+	(void) task;
+
+	pthread_mutex_lock(&pool_mp);
+	if (--pool.users == 0)
+	{
+		stop_workers(pool.count);
+	}
+	pthread_mutex_unlock(&pool_mp);
+}
+
+void dsp_pool_schedule(dsp_task_t *task)
+{
+	pthread_mutex_lock(&task->mp);
+	if (task->state == TASK_IDLE)
+	{
+		task->state = TASK_QUEUED;
+		enqueue_task(&pool.workers[task->home], task);
+	}
+	else if (task->state == TASK_RUNNING)
+	{
+		task->rerun = 1;
+	}
+	pthread_mutex_unlock(&task->mp);
+}
+
+void dsp_pool_wait_idle(dsp_task_t *task)
+{
+	pthread_mutex_lock(&task->mp);
+	while (task->state != TASK_IDLE)
+	{
+		pthread_cond_wait(&task->cv, &task->mp);
+	}
+	pthread_mutex_unlock(&task->mp);
+}
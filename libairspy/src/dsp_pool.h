@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DSP_POOL_H
+#define DSP_POOL_H
+
+#include <stdint.h>
+
+#if _MSC_VER > 1700 && !defined(HAVE_STRUCT_TIMESPEC)
+#define HAVE_STRUCT_TIMESPEC
+#endif
+
+#include <pthread.h>
+
+#define DSP_POOL_MAX_THREADS 64
+
+/* Processes a batch of work, returns non-zero when more is waiting */
+typedef int (*dsp_task_fn)(void *arg);
+
+/*
+ * A task is any source of work, here a device and its queued buffers. It
+ * is run by one worker at a time, so work of a task is processed in order
+ * and its state needs no lock, while different tasks run in parallel.
+ */
+typedef struct dsp_task {
+	dsp_task_fn run;
+	void *arg;
+	struct dsp_task *next;
+	uint32_t home;
+	int state;
+	int rerun;
+	pthread_mutex_t mp;
+	pthread_cond_t cv;
+} dsp_task_t;
+
+void dsp_task_init(dsp_task_t *task, dsp_task_fn run, void *arg);
+void dsp_task_destroy(dsp_task_t *task);
+
+/*
+ * Process-wide pool of workers with a run queue each. A task is queued on
+ * its home worker, idle workers steal from the others' queues. Started
+ * with the first task attached, stopped with the last one detached.
+ */
+/* Applies from the next start. thread_count 0 for one per core, cpus NULL for no affinity */
+int dsp_pool_configure(uint32_t thread_count, const int *cpus, uint32_t cpu_count, int priority);
+int dsp_pool_attach(dsp_task_t *task);
+void dsp_pool_detach(dsp_task_t *task);
+
+/* Queues the task unless already queued. Called while it runs, the task runs once more */
+void dsp_pool_schedule(dsp_task_t *task);
+/* Returns once the task is neither queued nor running */
+void dsp_pool_wait_idle(dsp_task_t *task);
+
+#endif // DSP_POOL_H
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <string.h>
+#include "histogram.h"
+
+static unsigned int highest_bit(uint64_t value)
+{
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(value);
+#else
+	unsigned int bit = 0;
+
+	while (value >>= 1)
+	{
+		bit++;
+	}
+
+	return bit;
+#endif
+}
+
+void histogram_reset(histogram_t *histogram)
+{
+	memset(histogram, 0, sizeof(histogram_t));
+}
+
+void histogram_add(histogram_t *histogram, uint64_t value)
+{
+	if (histogram->count == 0 || value < histogram->min)
+	{
+		histogram->min = value;
+	}
+	if (value > histogram->max)
+	{
+		histogram->max = value;
+	}
+
+	histogram->buckets[histogram_bucket(value)]++;
+	histogram->sum += value;
+	histogram->count++;
+}
+
+unsigned int histogram_bucket(uint64_t value)
+{
+	unsigned int bit;
+
+	if (value < HISTOGRAM_SUB_BUCKETS)
+	{
+		return (unsigned int) value;
+	}
+
+	bit = highest_bit(value);
+	if (bit >= HISTOGRAM_MAX_BITS)
+	{
+		return HISTOGRAM_BUCKETS - 1;
+	}
+
+	return (bit - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + (unsigned int) ((value >> (bit - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+uint64_t histogram_bucket_limit(unsigned int bucket)
+{
+	unsigned int shift;
+
+	if (bucket < HISTOGRAM_SUB_BUCKETS)
+	{
+		return bucket;
+	}
+
+	if (bucket >= HISTOGRAM_BUCKETS - 1)
+	{
+		return UINT64_MAX;
+	}
+
+	shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+
+	return ((uint64_t) (HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS + 1) << shift) - 1;
+}
+
+void histogram_fold_log2(const histogram_t *histogram, uint64_t *out, unsigned int count)
+{
+	unsigned int i;
+	unsigned int j;
+	uint64_t limit;
+
+	memset(out, 0, count * sizeof(uint64_t));
+
+	// Every bucket lies within one power of two
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		limit = histogram_bucket_limit(i);
+		j = limit == 0 ? 0 : highest_bit(limit) + 1;
+		out[j < count ? j : count - 1] += histogram->buckets[i];
+	}
+}
+
+uint64_t histogram_percentile(const histogram_t *histogram, double fraction)
+{
+	unsigned int i;
+	uint64_t rank;
+	uint64_t seen = 0;
+	uint64_t limit;
+
+	if (histogram->count == 0)
+	{
+		return 0;
+	}
+
+	rank = (uint64_t) (fraction * (double) histogram->count + 0.5);
+	if (rank < 1)
+	{
+		rank = 1;
+	}
+
+	for (i = 0; i < HISTOGRAM_BUCKETS - 1; i++)
+	{
+		seen += histogram->buckets[i];
+		if (seen >= rank)
+		{
+			break;
+		}
+	}
+
+	limit = histogram_bucket_limit(i);
+
+	return limit < histogram->max ? limit : histogram->max;
+}
@@ -21,11 +21,16 @@ THE SOFTWARE.
 */
 
 #include "iqconverter_float.h"
+#include "cpu_features.h"
 #include <stdlib.h>
 #include <string.h>
 
 #include <stdio.h>
 
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
 #if defined(__MINGW32__) && !defined(__MINGW64_VERSION_MAJOR)
   #include <malloc.h>
   #define _aligned_malloc __mingw_aligned_malloc
@@ -39,8 +44,6 @@ THE SOFTWARE.
   #define _inline inline
   #define FIR_STANDARD
 #elif defined(__FreeBSD__)
-  #define USE_SSE2
-#include <immintrin.h>
   #define _inline inline
   #define _aligned_free(mem) free(mem)
 void *_aligned_malloc(size_t size, size_t alignment)
@@ -55,14 +58,10 @@ void *_aligned_malloc(size_t size, size_t alignment)
   #define _aligned_malloc(size, alignment) memalign(alignment, size)
   #define _aligned_free(mem) free(mem)
   #define _inline inline
-#else
-	#if (_MSC_VER >= 1800)
-		//#define USE_SSE2
-		//#include <immintrin.h>
-	#endif
 #endif
 
-#define SIZE_FACTOR 32
+// Pairs per tile, the FIR history holds len - 1 + FIR_BLOCK_SIZE samples
+#define FIR_BLOCK_SIZE (IQCONVERTER_FLOAT_TILE_SIZE / 2)
 #define DEFAULT_ALIGNMENT 16
 #define HPF_COEFF 0.01f
 
@@ -72,27 +71,81 @@ void *_aligned_malloc(size_t size, size_t alignment)
 	#define ALIGNED
 #endif
 
+typedef struct {
+	void (*fir)(const iqconverter_float_t *cnv, const float *x, float *out, int count);
+	void (*split)(float *even, float *odd, const float *samples, int count, float hbc);
+	void (*merge)(float *samples, const float *even, const float *odd, int count);
+	void (*remove_dc)(iqconverter_float_t *cnv, float *samples, int len);
+	const char *fir_variant;
+	const char *split_variant;
+	const char *remove_dc_variant;
+} iqconverter_float_kernels_t;
+
+static void fir_block_scalar(const iqconverter_float_t *cnv, const float *x, float *out, int count);
+static void split_scalar(float *even, float *odd, const float *samples, int count, float hbc);
+static void merge_scalar(float *samples, const float *even, const float *odd, int count);
+static void remove_dc_scalar(iqconverter_float_t *cnv, float *samples, int len);
+
+static iqconverter_float_kernels_t kernels =
+{
+	fir_block_scalar,
+	split_scalar,
+	merge_scalar,
+	remove_dc_scalar,
+	"scalar",
+	"scalar",
+	"scalar"
+};
+
+static void allocate_buffers(iqconverter_float_t *cnv)
+{
+	size_t buffer_size = cnv->len * sizeof(float);
+
+	cnv->fir_kernel = (float *) _aligned_malloc(buffer_size, DEFAULT_ALIGNMENT);
+	cnv->fir_queue = (float *) _aligned_malloc(buffer_size + FIR_BLOCK_SIZE * sizeof(float), DEFAULT_ALIGNMENT);
+	cnv->delay_line = (float *) _aligned_malloc(buffer_size / 2 + FIR_BLOCK_SIZE * sizeof(float), DEFAULT_ALIGNMENT);
+
+	iqconverter_float_reset(cnv);
+}
+
 iqconverter_float_t *iqconverter_float_create(const float *hb_kernel, int len)
 {
 	int i, j;
-	size_t buffer_size;
 	iqconverter_float_t *cnv = (iqconverter_float_t *) _aligned_malloc(sizeof(iqconverter_float_t), DEFAULT_ALIGNMENT);
 
 	cnv->len = len / 2 + 1;
 	cnv->hbc = hb_kernel[len / 2];
 
-	buffer_size = cnv->len * sizeof(float);
-
-	cnv->fir_kernel = (float *) _aligned_malloc(buffer_size, DEFAULT_ALIGNMENT);
-	cnv->fir_queue = (float *) _aligned_malloc(buffer_size * SIZE_FACTOR, DEFAULT_ALIGNMENT);
-	cnv->delay_line = (float *) _aligned_malloc(buffer_size / 2, DEFAULT_ALIGNMENT);
-
-	iqconverter_float_reset(cnv);
+	allocate_buffers(cnv);
 
+	// Stored reversed, see fir_block_scalar()
 	for (i = 0, j = 0; i < cnv->len; i++, j += 2)
 	{
-		cnv->fir_kernel[i] = hb_kernel[j];
-	} 
+		cnv->fir_kernel[cnv->len - 1 - i] = hb_kernel[j];
+	}
+
+	cnv->fir_symmetric = 1;
+	for (i = 0; i < cnv->len / 2; i++)
+	{
+		if (cnv->fir_kernel[i] != cnv->fir_kernel[cnv->len - 1 - i])
+		{
+			cnv->fir_symmetric = 0;
+		}
+	}
+
+	return cnv;
+}
+
+iqconverter_float_t *iqconverter_float_clone(const iqconverter_float_t *src)
+{
+	iqconverter_float_t *cnv = (iqconverter_float_t *) _aligned_malloc(sizeof(iqconverter_float_t), DEFAULT_ALIGNMENT);
+
+	cnv->len = src->len;
+	cnv->hbc = src->hbc;
+	cnv->fir_symmetric = src->fir_symmetric;
+
+	allocate_buffers(cnv);
+	memcpy(cnv->fir_kernel, src->fir_kernel, cnv->len * sizeof(float));
 
 	return cnv;
 }
@@ -108,52 +161,19 @@ void iqconverter_float_free(iqconverter_float_t *cnv)
 void iqconverter_float_reset(iqconverter_float_t *cnv)
 {
 	cnv->avg = 0.0f;
-	cnv->fir_index = 0;
-	cnv->delay_index = 0;
-	memset(cnv->delay_line, 0, cnv->len * sizeof(float) / 2);
-	memset(cnv->fir_queue, 0, cnv->len * sizeof(float) * SIZE_FACTOR);
+	memset(cnv->delay_line, 0, (cnv->len >> 1) * sizeof(float));
+	memset(cnv->fir_queue, 0, (cnv->len - 1) * sizeof(float));
 }
 
-static _inline float process_fir_taps(const float *kernel, const float *queue, int len)
+static _inline float process_fir_taps_scalar(const float *kernel, const float *queue, int len)
 {
 	int i;
-
-#ifdef USE_SSE2
-
-	__m128 acc = _mm_set_ps(0, 0, 0, 0);
-
-#else
-
 	float sum = 0.0f;
 
-#endif
-
 	if (len >= 8)
 	{
 		int it = len >> 3;
 
-#ifdef USE_SSE2
-
-		for (i = 0; i < it; i++)
-		{
-			__m128 head1 = _mm_loadu_ps(queue);
-			__m128 kern1 = _mm_load_ps(kernel);
-			__m128 head2 = _mm_loadu_ps(queue + 4);
-			__m128 kern2 = _mm_load_ps(kernel + 4);
-
-			__m128 mul1 = _mm_mul_ps(kern1, head1);
-			__m128 mul2 = _mm_mul_ps(kern2, head2);
-
-			mul1 = _mm_add_ps(mul1, mul2);
-
-			acc = _mm_add_ps(acc, mul1);
-
-			queue += 8;
-			kernel += 8;
-		}
-
-#else
-
 		for (i = 0; i < it; i++)
 		{
 			sum += kernel[0] * queue[0]
@@ -163,187 +183,105 @@ static _inline float process_fir_taps(const float *kernel, const float *queue, i
 				+ kernel[4] * queue[4]
 				+ kernel[5] * queue[5]
 				+ kernel[6] * queue[6]
-				+ kernel[7] * queue[7];
-
-			queue += 8;
+				+ kernel[7] * queue[7];
+
+			queue += 8;
 			kernel += 8;
 		}
 
-#endif
 		len &= 7;
 	}
 
 	if (len >= 4)
 	{
-
-#ifdef USE_SSE2
-
-		__m128 head = _mm_loadu_ps(queue);
-		__m128 kern = _mm_load_ps(kernel);
-		__m128 mul = _mm_mul_ps(kern, head);
-		acc = _mm_add_ps(acc, mul);
-
-#else
-
 		sum += kernel[0] * queue[0]
 			+ kernel[1] * queue[1]
 			+ kernel[2] * queue[2]
 			+ kernel[3] * queue[3];
 
-#endif
-
 		kernel += 4;
 		queue += 4;
 		len &= 3;
-	}
-
-#ifdef USE_SSE2
-
-	__m128 t = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
-	acc = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
-
-#ifdef __FreeBSD__
-	float sum = acc[0];
-#else
-	float sum = acc.m128_f32[0];
-#endif
-
-#endif
+	}
 
-	if (len >= 2)
+	for (i = 0; i < len; i++)
 	{
-		sum += kernel[0] * queue[0]
-			+ kernel[1] * queue[1];
-
-		//kernel += 2;
-		//queue += 2;
-		//len &= 1;
+		sum += kernel[i] * queue[i];
 	}
 
-	//if (len >= 1)
-	//{
-	//	sum += kernel[0] * queue[0];
-	//}
-
 	return sum;
 }
 
-static void fir_interleaved_4(iqconverter_float_t *cnv, float *samples, int len)
+/*
+ * The FIR kernels below work on a linear history buffer holding the even
+ * stream in arrival order: output k is sum(kernel[t] * x[k + t]) for
+ * t < len, so x[k + len - 1] is the newest sample. The kernel is stored
+ * reversed to make this a plain correlation. Outputs may be written over
+ * x since output k never reads below x[k].
+ */
+
+static void fir_block_4(const iqconverter_float_t *cnv, const float *x, float *out, int count)
 {
 	int i;
-	int fir_index = cnv->fir_index;
-	int fir_len = cnv->len;
-	float *fir_kernel = cnv->fir_kernel;
-	float *fir_queue = cnv->fir_queue;
-	float *queue;
-	float acc;
+	const float *fir_kernel = cnv->fir_kernel;
+	const float *queue;
 
-	for (i = 0; i < len; i += 2)
+	for (i = 0; i < count; i++)
 	{
-		queue = fir_queue + fir_index;
+		queue = x + i;
 
-		queue[0] = samples[i];
-
-		acc = fir_kernel[0] * (queue[0] + queue[4 - 1])
+		out[i] = fir_kernel[0] * (queue[0] + queue[4 - 1])
 			+ fir_kernel[1] * (queue[1] + queue[4 - 2]);
-
-		samples[i] = acc;
-
-		if (--fir_index < 0)
-		{
-			fir_index = fir_len * (SIZE_FACTOR - 1);
-			memcpy(fir_queue + fir_index + 1, fir_queue, (fir_len - 1) * sizeof(float));
-		}
 	}
-
-	cnv->fir_index = fir_index;
 }
 
-static void fir_interleaved_8(iqconverter_float_t *cnv, float *samples, int len)
+static void fir_block_8(const iqconverter_float_t *cnv, const float *x, float *out, int count)
 {
 	int i;
-	int fir_index = cnv->fir_index;
-	int fir_len = cnv->len;
-	float *fir_kernel = cnv->fir_kernel;
-	float *fir_queue = cnv->fir_queue;
-	float *queue;
-	float acc;
+	const float *fir_kernel = cnv->fir_kernel;
+	const float *queue;
 
-	for (i = 0; i < len; i += 2)
+	for (i = 0; i < count; i++)
 	{
-		queue = fir_queue + fir_index;
-
-		queue[0] = samples[i];
+		queue = x + i;
 
-		acc = fir_kernel[0] * (queue[0] + queue[8 - 1])
+		out[i] = fir_kernel[0] * (queue[0] + queue[8 - 1])
 			+ fir_kernel[1] * (queue[1] + queue[8 - 2])
 			+ fir_kernel[2] * (queue[2] + queue[8 - 3])
 			+ fir_kernel[3] * (queue[3] + queue[8 - 4]);
-
-		samples[i] = acc;
-
-		if (--fir_index < 0)
-		{
-			fir_index = fir_len * (SIZE_FACTOR - 1);
-			memcpy(fir_queue + fir_index + 1, fir_queue, (fir_len - 1) * sizeof(float));
-		}
 	}
-
-	cnv->fir_index = fir_index;
 }
 
-static void fir_interleaved_12(iqconverter_float_t *cnv, float *samples, int len)
+static void fir_block_12(const iqconverter_float_t *cnv, const float *x, float *out, int count)
 {
 	int i;
-	int fir_index = cnv->fir_index;
-	int fir_len = cnv->len;
-	float *fir_kernel = cnv->fir_kernel;
-	float *fir_queue = cnv->fir_queue;
-	float *queue;
-	float acc = 0;
+	const float *fir_kernel = cnv->fir_kernel;
+	const float *queue;
 
-	for (i = 0; i < len; i += 2)
+	for (i = 0; i < count; i++)
 	{
-		queue = fir_queue + fir_index;
-
-		queue[0] = samples[i];
+		queue = x + i;
 
-		acc = fir_kernel[0]  * (queue[0]  + queue[12 - 1])
+		out[i] = fir_kernel[0]  * (queue[0]  + queue[12 - 1])
 			+ fir_kernel[1]  * (queue[1]  + queue[12 - 2])
 			+ fir_kernel[2]  * (queue[2]  + queue[12 - 3])
 			+ fir_kernel[3]  * (queue[3]  + queue[12 - 4])
 			+ fir_kernel[4]  * (queue[4]  + queue[12 - 5])
 			+ fir_kernel[5]  * (queue[5]  + queue[12 - 6]);
-
-		samples[i] = acc;
-
-		if (--fir_index < 0)
-		{
-			fir_index = fir_len * (SIZE_FACTOR - 1);
-			memcpy(fir_queue + fir_index + 1, fir_queue, (fir_len - 1) * sizeof(float));
-		}
 	}
-
-	cnv->fir_index = fir_index;
 }
 
-static void fir_interleaved_24(iqconverter_float_t *cnv, float *samples, int len)
+static void fir_block_24(const iqconverter_float_t *cnv, const float *x, float *out, int count)
 {
 	int i;
-	int fir_index = cnv->fir_index;
-	int fir_len = cnv->len;
-	float *fir_kernel = cnv->fir_kernel;
-	float *fir_queue = cnv->fir_queue;
-	float *queue;
-	float acc = 0;
+	const float *fir_kernel = cnv->fir_kernel;
+	const float *queue;
 
-	for (i = 0; i < len; i += 2)
+	for (i = 0; i < count; i++)
 	{
-		queue = fir_queue + fir_index;
-
-		queue[0] = samples[i];
+		queue = x + i;
 
-		acc = fir_kernel[0]  * (queue[0]  + queue[24 - 1])
+		out[i] = fir_kernel[0]  * (queue[0]  + queue[24 - 1])
 			+ fir_kernel[1]  * (queue[1]  + queue[24 - 2])
 			+ fir_kernel[2]  * (queue[2]  + queue[24 - 3])
 			+ fir_kernel[3]  * (queue[3]  + queue[24 - 4])
@@ -355,96 +293,396 @@ static void fir_interleaved_24(iqconverter_float_t *cnv, float *samples, int len
 			+ fir_kernel[9]  * (queue[9]  + queue[24 - 10])
 			+ fir_kernel[10] * (queue[10] + queue[24 - 11])
 			+ fir_kernel[11] * (queue[11] + queue[24 - 12]);
+	}
+}
 
-		samples[i] = acc;
+static void fir_block_scalar(const iqconverter_float_t *cnv, const float *x, float *out, int count)
+{
+	int i;
 
-		if (--fir_index < 0)
+	if (cnv->fir_symmetric)
+	{
+		switch (cnv->len)
 		{
-			fir_index = fir_len * (SIZE_FACTOR - 1);
-			memcpy(fir_queue + fir_index + 1, fir_queue, (fir_len - 1) * sizeof(float));
+		case 4:
+			fir_block_4(cnv, x, out, count);
+			return;
+		case 8:
+			fir_block_8(cnv, x, out, count);
+			return;
+		case 12:
+			fir_block_12(cnv, x, out, count);
+			return;
+		case 24:
+			fir_block_24(cnv, x, out, count);
+			return;
 		}
 	}
 
-	cnv->fir_index = fir_index;
+	for (i = 0; i < count; i++)
+	{
+		out[i] = process_fir_taps_scalar(cnv->fir_kernel, x + i, cnv->len);
+	}
 }
 
-static void fir_interleaved_generic(iqconverter_float_t *cnv, float *samples, int len)
+#ifdef CPU_FEATURES_X86
+
+/*
+ * Multi-output kernels: each tap is broadcast and applied to a run of
+ * consecutive outputs, so there is no horizontal reduction. Symmetric
+ * kernels add the mirrored samples first and use half the multiplies.
+ * Every output goes through the same sequence of operations whatever its
+ * position in the block, so the result does not depend on the block size.
+ */
+
+TARGET_SSE2 static _inline __m128 fir_taps_sse2(const float *kernel, const float *x, int len, int pairs)
 {
-	int i;
-	int fir_index = cnv->fir_index;
-	int fir_len = cnv->len;
-	float *fir_kernel = cnv->fir_kernel;
-	float *fir_queue = cnv->fir_queue;
-	float *queue;
+	int t;
+	__m128 acc = _mm_setzero_ps();
+
+	for (t = 0; t < pairs; t++)
+	{
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(kernel[t]), _mm_add_ps(_mm_loadu_ps(x + t), _mm_loadu_ps(x + len - 1 - t))));
+	}
 
-	for (i = 0; i < len; i += 2)
+	for (; t < len - pairs; t++)
 	{
-		queue = fir_queue + fir_index;
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(kernel[t]), _mm_loadu_ps(x + t)));
+	}
 
-		queue[0] = samples[i];
+	return acc;
+}
 
-		samples[i] = process_fir_taps(fir_kernel, queue, fir_len);
+TARGET_SSE2 static _inline float fir_taps_ss(const float *kernel, const float *x, int len, int pairs)
+{
+	int t;
+	__m128 acc = _mm_setzero_ps();
 
-		if (--fir_index < 0)
+	for (t = 0; t < pairs; t++)
+	{
+		acc = _mm_add_ss(acc, _mm_mul_ss(_mm_load_ss(kernel + t), _mm_add_ss(_mm_load_ss(x + t), _mm_load_ss(x + len - 1 - t))));
+	}
+
+	for (; t < len - pairs; t++)
+	{
+		acc = _mm_add_ss(acc, _mm_mul_ss(_mm_load_ss(kernel + t), _mm_load_ss(x + t)));
+	}
+
+	return _mm_cvtss_f32(acc);
+}
+
+TARGET_SSE2 static void fir_block_sse2(const iqconverter_float_t *cnv, const float *x, float *out, int count)
+{
+	int i, t;
+	int len = cnv->len;
+	int pairs = cnv->fir_symmetric ? len / 2 : 0;
+	const float *kernel = cnv->fir_kernel;
+	const float *p;
+	const float *q;
+	__m128 c, acc0, acc1, acc2, acc3;
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		p = x + i;
+		q = p + len - 1;
+		acc0 = acc1 = acc2 = acc3 = _mm_setzero_ps();
+
+		for (t = 0; t < pairs; t++)
+		{
+			c = _mm_set1_ps(kernel[t]);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(c, _mm_add_ps(_mm_loadu_ps(p + t), _mm_loadu_ps(q - t))));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(c, _mm_add_ps(_mm_loadu_ps(p + t + 4), _mm_loadu_ps(q - t + 4))));
+			acc2 = _mm_add_ps(acc2, _mm_mul_ps(c, _mm_add_ps(_mm_loadu_ps(p + t + 8), _mm_loadu_ps(q - t + 8))));
+			acc3 = _mm_add_ps(acc3, _mm_mul_ps(c, _mm_add_ps(_mm_loadu_ps(p + t + 12), _mm_loadu_ps(q - t + 12))));
+		}
+
+		for (; t < len - pairs; t++)
 		{
-			fir_index = fir_len * (SIZE_FACTOR - 1);
-			memcpy(fir_queue + fir_index + 1, fir_queue, (fir_len - 1) * sizeof(float));
+			c = _mm_set1_ps(kernel[t]);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(c, _mm_loadu_ps(p + t)));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(c, _mm_loadu_ps(p + t + 4)));
+			acc2 = _mm_add_ps(acc2, _mm_mul_ps(c, _mm_loadu_ps(p + t + 8)));
+			acc3 = _mm_add_ps(acc3, _mm_mul_ps(c, _mm_loadu_ps(p + t + 12)));
 		}
+
+		_mm_storeu_ps(out + i, acc0);
+		_mm_storeu_ps(out + i + 4, acc1);
+		_mm_storeu_ps(out + i + 8, acc2);
+		_mm_storeu_ps(out + i + 12, acc3);
+	}
+
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(out + i, fir_taps_sse2(kernel, x + i, len, pairs));
 	}
 
-	cnv->fir_index = fir_index;
+	for (; i < count; i++)
+	{
+		out[i] = fir_taps_ss(kernel, x + i, len, pairs);
+	}
 }
 
-static void fir_interleaved(iqconverter_float_t *cnv, float *samples, int len)
+TARGET_AVX2_FMA static _inline __m256 fir_taps_avx2(const float *kernel, const float *x, int len, int pairs)
 {
-	switch (cnv->len)
+	int t;
+	__m256 acc = _mm256_setzero_ps();
+
+	for (t = 0; t < pairs; t++)
 	{
-	case 4:
-		fir_interleaved_4(cnv, samples, len);
-		break;
-	case 8:
-		fir_interleaved_8(cnv, samples, len);
-		break;
-	case 12:
-		fir_interleaved_12(cnv, samples, len);
-		break;
-	case 24:
-		fir_interleaved_24(cnv, samples, len);
-		break;
-	default:
-		fir_interleaved_generic(cnv, samples, len);
-		break;
+		acc = _mm256_fmadd_ps(_mm256_broadcast_ss(kernel + t), _mm256_add_ps(_mm256_loadu_ps(x + t), _mm256_loadu_ps(x + len - 1 - t)), acc);
 	}
+
+	for (; t < len - pairs; t++)
+	{
+		acc = _mm256_fmadd_ps(_mm256_broadcast_ss(kernel + t), _mm256_loadu_ps(x + t), acc);
+	}
+
+	return acc;
 }
 
-static void delay_interleaved(iqconverter_float_t *cnv, float *samples, int len)
+TARGET_AVX2_FMA static _inline float fir_taps_fma_ss(const float *kernel, const float *x, int len, int pairs)
 {
-	int i;
-	ALIGNED int index;
-	ALIGNED int half_len;
-	ALIGNED float res;
-	
-	half_len = cnv->len >> 1;
-	index = cnv->delay_index;
+	int t;
+	__m128 acc = _mm_setzero_ps();
 
-	for (i = 0; i < len; i += 2)
+	for (t = 0; t < pairs; t++)
 	{
-		res = cnv->delay_line[index];
-		cnv->delay_line[index] = samples[i];
-		samples[i] = res;
+		acc = _mm_fmadd_ss(_mm_load_ss(kernel + t), _mm_add_ss(_mm_load_ss(x + t), _mm_load_ss(x + len - 1 - t)), acc);
+	}
+
+	for (; t < len - pairs; t++)
+	{
+		acc = _mm_fmadd_ss(_mm_load_ss(kernel + t), _mm_load_ss(x + t), acc);
+	}
+
+	return _mm_cvtss_f32(acc);
+}
 
-		if (++index >= half_len)
+TARGET_AVX2_FMA static void fir_block_avx2(const iqconverter_float_t *cnv, const float *x, float *out, int count)
+{
+	int i, t;
+	int len = cnv->len;
+	int pairs = cnv->fir_symmetric ? len / 2 : 0;
+	const float *kernel = cnv->fir_kernel;
+	const float *p;
+	const float *q;
+	__m256 c, acc0, acc1, acc2, acc3;
+
+	for (i = 0; i + 32 <= count; i += 32)
+	{
+		p = x + i;
+		q = p + len - 1;
+		acc0 = acc1 = acc2 = acc3 = _mm256_setzero_ps();
+
+		for (t = 0; t < pairs; t++)
+		{
+			c = _mm256_broadcast_ss(kernel + t);
+			acc0 = _mm256_fmadd_ps(c, _mm256_add_ps(_mm256_loadu_ps(p + t), _mm256_loadu_ps(q - t)), acc0);
+			acc1 = _mm256_fmadd_ps(c, _mm256_add_ps(_mm256_loadu_ps(p + t + 8), _mm256_loadu_ps(q - t + 8)), acc1);
+			acc2 = _mm256_fmadd_ps(c, _mm256_add_ps(_mm256_loadu_ps(p + t + 16), _mm256_loadu_ps(q - t + 16)), acc2);
+			acc3 = _mm256_fmadd_ps(c, _mm256_add_ps(_mm256_loadu_ps(p + t + 24), _mm256_loadu_ps(q - t + 24)), acc3);
+		}
+
+		for (; t < len - pairs; t++)
 		{
-			index = 0;
+			c = _mm256_broadcast_ss(kernel + t);
+			acc0 = _mm256_fmadd_ps(c, _mm256_loadu_ps(p + t), acc0);
+			acc1 = _mm256_fmadd_ps(c, _mm256_loadu_ps(p + t + 8), acc1);
+			acc2 = _mm256_fmadd_ps(c, _mm256_loadu_ps(p + t + 16), acc2);
+			acc3 = _mm256_fmadd_ps(c, _mm256_loadu_ps(p + t + 24), acc3);
 		}
+
+		_mm256_storeu_ps(out + i, acc0);
+		_mm256_storeu_ps(out + i + 8, acc1);
+		_mm256_storeu_ps(out + i + 16, acc2);
+		_mm256_storeu_ps(out + i + 24, acc3);
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(out + i, fir_taps_avx2(kernel, x + i, len, pairs));
+	}
+
+	for (; i < count; i++)
+	{
+		out[i] = fir_taps_fma_ss(kernel, x + i, len, pairs);
 	}
-	
-	cnv->delay_index = index;
 }
 
+#ifdef CPU_FEATURES_X86_AVX512
+
+TARGET_AVX512 static void fir_block_avx512(const iqconverter_float_t *cnv, const float *x, float *out, int count)
+{
+	int i, t;
+	int len = cnv->len;
+	int pairs = cnv->fir_symmetric ? len / 2 : 0;
+	const float *kernel = cnv->fir_kernel;
+	const float *p;
+	const float *q;
+	__m512 c, acc0, acc1, acc2, acc3;
+
+	for (i = 0; i + 64 <= count; i += 64)
+	{
+		p = x + i;
+		q = p + len - 1;
+		acc0 = acc1 = acc2 = acc3 = _mm512_setzero_ps();
+
+		for (t = 0; t < pairs; t++)
+		{
+			c = _mm512_set1_ps(kernel[t]);
+			acc0 = _mm512_fmadd_ps(c, _mm512_add_ps(_mm512_loadu_ps(p + t), _mm512_loadu_ps(q - t)), acc0);
+			acc1 = _mm512_fmadd_ps(c, _mm512_add_ps(_mm512_loadu_ps(p + t + 16), _mm512_loadu_ps(q - t + 16)), acc1);
+			acc2 = _mm512_fmadd_ps(c, _mm512_add_ps(_mm512_loadu_ps(p + t + 32), _mm512_loadu_ps(q - t + 32)), acc2);
+			acc3 = _mm512_fmadd_ps(c, _mm512_add_ps(_mm512_loadu_ps(p + t + 48), _mm512_loadu_ps(q - t + 48)), acc3);
+		}
+
+		for (; t < len - pairs; t++)
+		{
+			c = _mm512_set1_ps(kernel[t]);
+			acc0 = _mm512_fmadd_ps(c, _mm512_loadu_ps(p + t), acc0);
+			acc1 = _mm512_fmadd_ps(c, _mm512_loadu_ps(p + t + 16), acc1);
+			acc2 = _mm512_fmadd_ps(c, _mm512_loadu_ps(p + t + 32), acc2);
+			acc3 = _mm512_fmadd_ps(c, _mm512_loadu_ps(p + t + 48), acc3);
+		}
+
+		_mm512_storeu_ps(out + i, acc0);
+		_mm512_storeu_ps(out + i + 16, acc1);
+		_mm512_storeu_ps(out + i + 32, acc2);
+		_mm512_storeu_ps(out + i + 48, acc3);
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(out + i, fir_taps_avx2(kernel, x + i, len, pairs));
+	}
+
+	for (; i < count; i++)
+	{
+		out[i] = fir_taps_fma_ss(kernel, x + i, len, pairs);
+	}
+}
+
+#endif
+
+#endif
+
+/*
+ * The converter runs one tile of FIR_BLOCK_SIZE pairs at a time through
+ * all stages so the data stays in L1. split() applies the fs/4 rotation
+ * while separating the even lanes into the FIR history and the odd lanes
+ * into the delay line, merge() interleaves the FIR output with the odd
+ * lanes delayed by len / 2. Both follow the pair phase from the start of
+ * the buffer, which stays aligned as tiles hold an even number of pairs.
+ */
+static void split_scalar(float *even, float *odd, const float *samples, int count, float hbc)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (i & 1)
+		{
+			even[i] = samples[i * 2];
+			odd[i] = samples[i * 2 + 1] * hbc;
+		}
+		else
+		{
+			even[i] = -samples[i * 2];
+			odd[i] = -samples[i * 2 + 1] * hbc;
+		}
+	}
+}
+
+static void merge_scalar(float *samples, const float *even, const float *odd, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		samples[i * 2] = even[i];
+		samples[i * 2 + 1] = odd[i];
+	}
+}
+
+#ifdef CPU_FEATURES_X86
+
+TARGET_SSE2 static void split_sse2(float *even, float *odd, const float *samples, int count, float hbc)
+{
+	int i;
+	__m128 a, b;
+	const __m128 rot = _mm_setr_ps(-1.0f, -hbc, 1.0f, hbc);
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		a = _mm_mul_ps(_mm_loadu_ps(samples + i * 2), rot);
+		b = _mm_mul_ps(_mm_loadu_ps(samples + i * 2 + 4), rot);
+		_mm_storeu_ps(even + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(odd + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+
+	split_scalar(even + i, odd + i, samples + i * 2, count - i, hbc);
+}
+
+TARGET_SSE2 static void merge_sse2(float *samples, const float *even, const float *odd, int count)
+{
+	int i;
+	__m128 e, o;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		e = _mm_loadu_ps(even + i);
+		o = _mm_loadu_ps(odd + i);
+		_mm_storeu_ps(samples + i * 2, _mm_unpacklo_ps(e, o));
+		_mm_storeu_ps(samples + i * 2 + 4, _mm_unpackhi_ps(e, o));
+	}
+
+	merge_scalar(samples + i * 2, even + i, odd + i, count - i);
+}
+
+TARGET_AVX2 static void split_avx2(float *even, float *odd, const float *samples, int count, float hbc)
+{
+	int i;
+	__m256 a, b, e, o;
+	const __m256 rot = _mm256_setr_ps(-1.0f, -hbc, 1.0f, hbc, -1.0f, -hbc, 1.0f, hbc);
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		a = _mm256_mul_ps(_mm256_loadu_ps(samples + i * 2), rot);
+		b = _mm256_mul_ps(_mm256_loadu_ps(samples + i * 2 + 8), rot);
+		e = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		o = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		e = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(e), _MM_SHUFFLE(3, 1, 2, 0)));
+		o = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(o), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_ps(even + i, e);
+		_mm256_storeu_ps(odd + i, o);
+	}
+
+	split_scalar(even + i, odd + i, samples + i * 2, count - i, hbc);
+}
+
+TARGET_AVX2 static void merge_avx2(float *samples, const float *even, const float *odd, int count)
+{
+	int i;
+	__m256 e, o, lo, hi;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		e = _mm256_loadu_ps(even + i);
+		o = _mm256_loadu_ps(odd + i);
+		lo = _mm256_unpacklo_ps(e, o);
+		hi = _mm256_unpackhi_ps(e, o);
+		_mm256_storeu_ps(samples + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(samples + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+
+	merge_scalar(samples + i * 2, even + i, odd + i, count - i);
+}
+
+#endif
+
 #define SCALE (0.01f)
 
-static void remove_dc(iqconverter_float_t *cnv, float *samples, int len)
+static void remove_dc_scalar(iqconverter_float_t *cnv, float *samples, int len)
 {
 	int i;
 	ALIGNED float avg = cnv->avg;
@@ -458,45 +696,306 @@ static void remove_dc(iqconverter_float_t *cnv, float *samples, int len)
 	cnv->avg = avg;
 }
 
-static void translate_fs_4(iqconverter_float_t *cnv, float *samples, int len)
+#ifdef CPU_FEATURES_X86
+
+/*
+ * remove_dc() is the recursion avg = (1 - SCALE) * avg + SCALE * x. The
+ * SIMD versions run it across a vector as a weighted prefix sum of
+ * SCALE * x, add the incoming average times the matching power of
+ * (1 - SCALE) and carry the last lane into the next vector. The result
+ * differs from the scalar recursion by rounding only, within 2e-6 for
+ * full scale input, far below one ADC step (2^-11).
+ */
+#define SHIFT_LANES_SSE2(v, n) _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), (n) * 4))
+
+TARGET_SSE2 static void remove_dc_sse2(iqconverter_float_t *cnv, float *samples, int len)
 {
 	int i;
-	ALIGNED float hbc = cnv->hbc;
-
-#ifdef USE_SSE2
+	float p = 1.0f - SCALE;
+	__m128 x, s;
+	__m128 avg = _mm_set1_ps(cnv->avg);
+	const __m128 scale = _mm_set1_ps(SCALE);
+	const __m128 p1 = _mm_set1_ps(p);
+	const __m128 p2 = _mm_set1_ps(p * p);
+	const __m128 p4 = _mm_set1_ps(p * p * p * p);
+	const __m128 powers = _mm_setr_ps(1.0f, p, p * p, p * p * p);
+
+	for (i = 0; i + 4 <= len; i += 4)
+	{
+		x = _mm_loadu_ps(samples + i);
+		s = _mm_mul_ps(x, scale);
+		s = _mm_add_ps(s, _mm_mul_ps(p1, SHIFT_LANES_SSE2(s, 1)));
+		s = _mm_add_ps(s, _mm_mul_ps(p2, SHIFT_LANES_SSE2(s, 2)));
+		_mm_storeu_ps(samples + i, _mm_sub_ps(x, _mm_add_ps(SHIFT_LANES_SSE2(s, 1), _mm_mul_ps(powers, avg))));
+		avg = _mm_add_ps(_mm_mul_ps(p4, avg), _mm_shuffle_ps(s, s, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
 
-	float *buf = samples;
-	ALIGNED __m128 vec;
-	ALIGNED __m128 rot = _mm_set_ps(hbc, 1.0f, -hbc, -1.0f);
+	cnv->avg = _mm_cvtss_f32(avg);
+	remove_dc_scalar(cnv, samples + i, len - i);
+}
 
-	for (i = 0; i < len / 4; i++, buf +=4)
+TARGET_AVX2_FMA static void remove_dc_avx2(iqconverter_float_t *cnv, float *samples, int len)
+{
+	int i;
+	float p = 1.0f - SCALE;
+	float p2 = p * p;
+	float p4 = p2 * p2;
+	__m256 x, s;
+	__m256 avg = _mm256_set1_ps(cnv->avg);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 scale = _mm256_set1_ps(SCALE);
+	const __m256 vp1 = _mm256_set1_ps(p);
+	const __m256 vp2 = _mm256_set1_ps(p2);
+	const __m256 vp4 = _mm256_set1_ps(p4);
+	const __m256 vp8 = _mm256_set1_ps(p4 * p4);
+	const __m256 powers = _mm256_setr_ps(1.0f, p, p2, p2 * p, p4, p4 * p, p4 * p2, p4 * p2 * p);
+	const __m256i shift1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+	const __m256i shift2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+	const __m256i last = _mm256_set1_epi32(7);
+
+	for (i = 0; i + 8 <= len; i += 8)
 	{
-		vec = _mm_loadu_ps(buf);
-		vec = _mm_mul_ps(vec, rot);
-		_mm_storeu_ps(buf, vec);
+		x = _mm256_loadu_ps(samples + i);
+		s = _mm256_mul_ps(x, scale);
+		s = _mm256_fmadd_ps(vp1, _mm256_blend_ps(_mm256_permutevar8x32_ps(s, shift1), zero, 0x01), s);
+		s = _mm256_fmadd_ps(vp2, _mm256_blend_ps(_mm256_permutevar8x32_ps(s, shift2), zero, 0x03), s);
+		s = _mm256_fmadd_ps(vp4, _mm256_permute2f128_ps(s, s, 0x08), s);
+		x = _mm256_sub_ps(x, _mm256_fmadd_ps(powers, avg, _mm256_blend_ps(_mm256_permutevar8x32_ps(s, shift1), zero, 0x01)));
+		_mm256_storeu_ps(samples + i, x);
+		avg = _mm256_fmadd_ps(vp8, avg, _mm256_permutevar8x32_ps(s, last));
 	}
 
-#else
+	cnv->avg = _mm256_cvtss_f32(avg);
+	remove_dc_scalar(cnv, samples + i, len - i);
+}
+
+#endif
 
-	int j;
+void iqconverter_float_init(uint32_t cpu_features)
+{
+	iqconverter_float_kernels_t selected;
+
+	selected.fir = fir_block_scalar;
+	selected.split = split_scalar;
+	selected.merge = merge_scalar;
+	selected.fir_variant = "scalar";
+	selected.split_variant = "scalar";
+	selected.remove_dc = remove_dc_scalar;
+	selected.remove_dc_variant = "scalar";
+
+#ifdef CPU_FEATURES_X86
+#ifdef CPU_FEATURES_X86_AVX512
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX512))
+	{
+		selected.fir = fir_block_avx512;
+		selected.fir_variant = "avx512";
+	}
+	else
+#endif
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX2_FMA))
+	{
+		selected.fir = fir_block_avx2;
+		selected.fir_variant = "avx2+fma";
+	}
+	else if (CPU_HAS(cpu_features, CPU_FEATURE_SSE2))
+	{
+		selected.fir = fir_block_sse2;
+		selected.fir_variant = "sse2";
+	}
 
-	for (i = 0; i < len / 4; i++)
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX2))
+	{
+		selected.split = split_avx2;
+		selected.merge = merge_avx2;
+		selected.split_variant = "avx2";
+	}
+	else if (CPU_HAS(cpu_features, CPU_FEATURE_SSE2))
 	{
-		j = i << 2;
-		samples[j + 0] = -samples[j + 0];
-		samples[j + 1] = -samples[j + 1] * hbc;
-		//samples[j + 2] = samples[j + 2];
-		samples[j + 3] = samples[j + 3] * hbc;
+		selected.split = split_sse2;
+		selected.merge = merge_sse2;
+		selected.split_variant = "sse2";
 	}
 
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX2_FMA))
+	{
+		selected.remove_dc = remove_dc_avx2;
+		selected.remove_dc_variant = "avx2+fma";
+	}
+	else if (CPU_HAS(cpu_features, CPU_FEATURE_SSE2))
+	{
+		selected.remove_dc = remove_dc_sse2;
+		selected.remove_dc_variant = "sse2";
+	}
 #endif
 
-	fir_interleaved(cnv, samples, len);
-	delay_interleaved(cnv, samples + 1, len);
+	kernels = selected;
+}
+
+const char *iqconverter_float_variant(const iqconverter_float_t *cnv, int kernel)
+{
+	switch (kernel)
+	{
+	case DSP_KERNEL_REMOVE_DC:
+		return kernels.remove_dc_variant;
+
+	case DSP_KERNEL_TRANSLATE:
+	case DSP_KERNEL_DELAY:
+		return kernels.split_variant;
+
+	case DSP_KERNEL_FIR:
+		if (kernels.fir == fir_block_scalar && cnv->fir_symmetric)
+		{
+			switch (cnv->len)
+			{
+			case 4:
+			case 8:
+			case 12:
+			case 24:
+				return "scalar-unrolled";
+			}
+		}
+		return kernels.fir_variant;
+
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * One tile of count pairs through the FIR and the delay line. A NULL
+ * output only shifts the samples into the history.
+ */
+static void filter_tile(iqconverter_float_t *cnv, float *samples, const float *input, int count)
+{
+	int history = cnv->len - 1;
+	int delay = cnv->len >> 1;
+	float *fir_queue = cnv->fir_queue;
+	float *delay_line = cnv->delay_line;
+
+	kernels.split(fir_queue + history, delay_line + delay, input, count, cnv->hbc);
+	if (samples != NULL)
+	{
+		kernels.fir(cnv, fir_queue, fir_queue, count);
+		kernels.merge(samples, fir_queue, delay_line, count);
+	}
+
+	memmove(fir_queue, fir_queue + count, history * sizeof(float));
+	memmove(delay_line, delay_line + count, delay * sizeof(float));
 }
 
 void iqconverter_float_process(iqconverter_float_t *cnv, float *samples, int len)
 {
-	remove_dc(cnv, samples, len);
-	translate_fs_4(cnv, samples, len);
+	int i, count;
+
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		kernels.remove_dc(cnv, samples + i, count * 2);
+		filter_tile(cnv, samples + i, samples + i, count);
+	}
+}
+
+void iqconverter_float_remove_dc(iqconverter_float_t *cnv, float *samples, int len)
+{
+	int i, count;
+
+	// Same segmentation as iqconverter_float_process()
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		kernels.remove_dc(cnv, samples + i, count * 2);
+	}
+}
+
+int iqconverter_float_history_size(const iqconverter_float_t *cnv)
+{
+	int history = cnv->len - 1;
+
+	// An even number of pairs so the fs/4 phase lines up with the chunk
+	return ((history + 1) & ~1) * 2;
+}
+
+/*
+ * Chunks start on a tile boundary so the tiles match process(), and past
+ * the filter history so each chunk can be seeded from the samples before
+ * it. Returns the number of chunks, bounds holds one more entry.
+ */
+int iqconverter_float_split(const iqconverter_float_t *cnv, int len, int max_chunks, int *bounds)
+{
+	int i;
+	int chunks;
+	int step;
+	int unit = IQCONVERTER_FLOAT_TILE_SIZE;
+
+	while (unit < iqconverter_float_history_size(cnv))
+	{
+		unit += IQCONVERTER_FLOAT_TILE_SIZE;
+	}
+
+	chunks = len / unit;
+	if (chunks > max_chunks)
+	{
+		chunks = max_chunks;
+	}
+	if (chunks < 1)
+	{
+		chunks = 1;
+	}
+
+	step = (len / chunks) / unit * unit;
+	for (i = 0; i < chunks; i++)
+	{
+		bounds[i] = i * step;
+	}
+	bounds[chunks] = len;
+
+	return chunks;
+}
+
+void iqconverter_float_load_history(iqconverter_float_t *cnv, const float *samples, int len)
+{
+	int i, count;
+
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		filter_tile(cnv, NULL, samples + i, count);
+	}
+}
+
+void iqconverter_float_copy_history(iqconverter_float_t *dst, const iqconverter_float_t *src)
+{
+	memcpy(dst->fir_queue, src->fir_queue, (src->len - 1) * sizeof(float));
+	memcpy(dst->delay_line, src->delay_line, (src->len >> 1) * sizeof(float));
+}
+
+void iqconverter_float_filter(iqconverter_float_t *cnv, float *samples, int len)
+{
+	int i, count;
+
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		filter_tile(cnv, samples + i, samples + i, count);
+	}
 }
@@ -28,20 +28,40 @@ THE SOFTWARE.
 #define IQCONVERTER_NZEROS 2
 #define IQCONVERTER_NPOLES 2
 
+// Samples per processing tile
+#define IQCONVERTER_FLOAT_TILE_SIZE 512
+
 typedef struct {
 	float avg;
 	float hbc;
 	int len;
-	int fir_index;
-	int delay_index;
+	int fir_symmetric;
 	float *fir_kernel;
 	float *fir_queue;
 	float *delay_line;
 } iqconverter_float_t;
 
+void iqconverter_float_init(uint32_t cpu_features);
+const char *iqconverter_float_variant(const iqconverter_float_t *cnv, int kernel);
 iqconverter_float_t *iqconverter_float_create(const float *hb_kernel, int len);
 void iqconverter_float_free(iqconverter_float_t *cnv);
 void iqconverter_float_reset(iqconverter_float_t *cnv);
 void iqconverter_float_process(iqconverter_float_t *cnv, float *samples, int len);
 
+/*
+ * Split form of iqconverter_float_process() for converting one buffer on
+ * several threads: remove_dc() runs over the whole buffer, then each chunk
+ * goes through filter() on its own clone whose history was loaded from the
+ * history_size() samples preceding the chunk. Chunks shall start on a
+ * multiple of IQCONVERTER_FLOAT_TILE_SIZE for the output to be identical,
+ * split() returns such chunks.
+ */
+iqconverter_float_t *iqconverter_float_clone(const iqconverter_float_t *cnv);
+void iqconverter_float_remove_dc(iqconverter_float_t *cnv, float *samples, int len);
+int iqconverter_float_history_size(const iqconverter_float_t *cnv);
+int iqconverter_float_split(const iqconverter_float_t *cnv, int len, int max_chunks, int *bounds);
+void iqconverter_float_load_history(iqconverter_float_t *cnv, const float *samples, int len);
+void iqconverter_float_copy_history(iqconverter_float_t *dst, const iqconverter_float_t *src);
+void iqconverter_float_filter(iqconverter_float_t *cnv, float *samples, int len);
+
 #endif // IQCONVERTER_FLOAT_H
@@ -21,9 +21,14 @@ THE SOFTWARE.
 */
 
 #include "iqconverter_int16.h"
+#include "cpu_features.h"
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
 #if defined(__MINGW32__) && !defined(__MINGW64_VERSION_MAJOR)
   #include <malloc.h>
   #define _aligned_malloc __mingw_aligned_malloc
@@ -45,29 +50,72 @@ void * _aligned_malloc(size_t size, size_t alignment);
   #define _inline inline
 #endif
 
-#define SIZE_FACTOR 16
+// Pairs per tile, the FIR history holds len - 1 + FIR_BLOCK_SIZE samples
+#define FIR_BLOCK_SIZE (IQCONVERTER_INT16_TILE_SIZE / 2)
+#define FIR_PADDING 64
 #define DEFAULT_ALIGNMENT 16
 
+typedef struct {
+	void (*fir)(const iqconverter_int16_t *cnv, const int16_t *x, int16_t *out, int count);
+	void (*split)(int16_t *even, int16_t *odd, const int16_t *samples, int count);
+	void (*merge)(int16_t *samples, const int16_t *even, const int16_t *odd, int count);
+	const char *fir_variant;
+	const char *split_variant;
+} iqconverter_int16_kernels_t;
+
+static void fir_block_scalar(const iqconverter_int16_t *cnv, const int16_t *x, int16_t *out, int count);
+static void split_scalar(int16_t *even, int16_t *odd, const int16_t *samples, int count);
+static void merge_scalar(int16_t *samples, const int16_t *even, const int16_t *odd, int count);
+
+static iqconverter_int16_kernels_t kernels =
+{
+	fir_block_scalar,
+	split_scalar,
+	merge_scalar,
+	"scalar",
+	"scalar"
+};
+
+static void allocate_buffers(iqconverter_int16_t *cnv)
+{
+	size_t buffer_size = (cnv->len + 1) * sizeof(int16_t);
+
+	cnv->fir_kernel = (int16_t *) _aligned_malloc(buffer_size, DEFAULT_ALIGNMENT);
+	cnv->fir_queue = (int16_t *) _aligned_malloc(buffer_size + (FIR_BLOCK_SIZE + FIR_PADDING) * sizeof(int16_t), DEFAULT_ALIGNMENT);
+	cnv->delay_line = (int16_t *) _aligned_malloc(((cnv->len >> 1) + FIR_BLOCK_SIZE) * sizeof(int16_t), DEFAULT_ALIGNMENT);
+
+	// The SIMD kernels read one tap and a few samples past the end
+	memset(cnv->fir_queue, 0, buffer_size + (FIR_BLOCK_SIZE + FIR_PADDING) * sizeof(int16_t));
+	iqconverter_int16_reset(cnv);
+}
+
 iqconverter_int16_t *iqconverter_int16_create(const int16_t *hb_kernel, int len)
 {
 	int i;
-	size_t buffer_size;
 	iqconverter_int16_t *cnv = (iqconverter_int16_t *) _aligned_malloc(sizeof(iqconverter_int16_t), DEFAULT_ALIGNMENT);
 
 	cnv->len = len / 2 + 1;
 
-	buffer_size = cnv->len * sizeof(int32_t);
-
-	cnv->fir_kernel = (int32_t *) _aligned_malloc(buffer_size, DEFAULT_ALIGNMENT);
-	cnv->fir_queue = (int32_t *) _aligned_malloc(buffer_size * SIZE_FACTOR, DEFAULT_ALIGNMENT);
-	cnv->delay_line = (int16_t *) _aligned_malloc(buffer_size / 4, DEFAULT_ALIGNMENT);
-
-	iqconverter_int16_reset(cnv);
+	allocate_buffers(cnv);
 
+	// Stored reversed, see fir_block_scalar()
 	for (i = 0; i < cnv->len; i++)
 	{
-		cnv->fir_kernel[i] = hb_kernel[i * 2];
+		cnv->fir_kernel[cnv->len - 1 - i] = hb_kernel[i * 2];
 	}
+	cnv->fir_kernel[cnv->len] = 0;
+
+	return cnv;
+}
+
+iqconverter_int16_t *iqconverter_int16_clone(const iqconverter_int16_t *src)
+{
+	iqconverter_int16_t *cnv = (iqconverter_int16_t *) _aligned_malloc(sizeof(iqconverter_int16_t), DEFAULT_ALIGNMENT);
+
+	cnv->len = src->len;
+
+	allocate_buffers(cnv);
+	memcpy(cnv->fir_kernel, src->fir_kernel, (cnv->len + 1) * sizeof(int16_t));
 
 	return cnv;
 }
@@ -82,78 +130,337 @@ void iqconverter_int16_free(iqconverter_int16_t *cnv)
 
 void iqconverter_int16_reset(iqconverter_int16_t *cnv)
 {
-	cnv->fir_index = 0;
-	cnv->delay_index = 0;
 	cnv->old_x = 0;
 	cnv->old_y = 0;
 	cnv->old_e = 0;
-	memset(cnv->delay_line, 0, cnv->len * sizeof(int16_t) / 4);
-	memset(cnv->fir_queue, 0, cnv->len * sizeof(int16_t) * SIZE_FACTOR);
+	memset(cnv->delay_line, 0, (cnv->len >> 1) * sizeof(int16_t));
+	memset(cnv->fir_queue, 0, (cnv->len - 1) * sizeof(int16_t));
 }
 
-static void fir_interleaved(iqconverter_int16_t *cnv, int16_t *samples, int len)
+/*
+ * The FIR works on a linear history buffer holding the even stream in
+ * arrival order: output k is sum(kernel[t] * x[k + t]) >> 15, the kernel
+ * being stored reversed and zero padded to an even number of taps.
+ * Outputs may be written over x since output k never reads below x[k].
+ */
+static void fir_block_scalar(const iqconverter_int16_t *cnv, const int16_t *x, int16_t *out, int count)
 {
-	int i;
-	int j;
-	int fir_index;
-	int fir_len;
-	int32_t *queue;
+	int i, j;
 	int32_t acc;
 
-	fir_len = cnv->len;
-	fir_index = cnv->fir_index;
+	for (i = 0; i < count; i++)
+	{
+		acc = 0;
+
+		for (j = 0; j < cnv->len; j++)
+		{
+			acc += cnv->fir_kernel[j] * x[i + j];
+		}
+
+		out[i] = acc >> 15;
+	}
+}
+
+#ifdef CPU_FEATURES_X86
+
+/*
+ * pmaddwd takes taps two at a time: interleaving x[k + t] with x[k + t + 1]
+ * lines up both products of a tap pair in one 32bit lane. The unpacks stay
+ * within 128bit lanes and so does the final pack, which puts the outputs
+ * back in order. The sums wrap exactly like the scalar code.
+ */
+static _inline int32_t fir_tap_pair(const int16_t *kernel)
+{
+	int32_t pair;
+	memcpy(&pair, kernel, sizeof(pair));
+	return pair;
+}
+
+TARGET_SSE2 static _inline __m128i fir_pack_sse2(__m128i lo, __m128i hi)
+{
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 1), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 1), 16);
+	return _mm_packs_epi32(lo, hi);
+}
+
+TARGET_SSE2 static _inline __m128i fir_taps_sse2(const int16_t *kernel, const int16_t *x, int taps)
+{
+	int t;
+	__m128i a, b, c;
+	__m128i lo = _mm_setzero_si128();
+	__m128i hi = _mm_setzero_si128();
 
-	for (i = 0; i < len; i += 2)
+	for (t = 0; t < taps; t += 2)
 	{
-		queue = cnv->fir_queue + fir_index;
+		c = _mm_set1_epi32(fir_tap_pair(kernel + t));
+		a = _mm_loadu_si128((const __m128i *) (x + t));
+		b = _mm_loadu_si128((const __m128i *) (x + t + 1));
+		lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), c));
+		hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), c));
+	}
 
-		queue[0] = samples[i];
+	return fir_pack_sse2(lo, hi);
+}
 
-		acc = 0;
-		
-		// Auto vectorization works on VS2012, VS2013 and GCC
-		for (j = 0; j < fir_len; j++)
+TARGET_SSE2 static void fir_block_sse2(const iqconverter_int16_t *cnv, const int16_t *x, int16_t *out, int count)
+{
+	int i, t;
+	int taps = (cnv->len + 1) & ~1;
+	const int16_t *kernel = cnv->fir_kernel;
+	const int16_t *p;
+	__m128i a, b, c, acc0, acc1, acc2, acc3;
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		p = x + i;
+		acc0 = acc1 = acc2 = acc3 = _mm_setzero_si128();
+
+		for (t = 0; t < taps; t += 2)
 		{
-			acc += cnv->fir_kernel[j] * queue[j];
+			c = _mm_set1_epi32(fir_tap_pair(kernel + t));
+			a = _mm_loadu_si128((const __m128i *) (p + t));
+			b = _mm_loadu_si128((const __m128i *) (p + t + 1));
+			acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), c));
+			acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), c));
+			a = _mm_loadu_si128((const __m128i *) (p + t + 8));
+			b = _mm_loadu_si128((const __m128i *) (p + t + 9));
+			acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), c));
+			acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), c));
 		}
 
-		if (--fir_index < 0)
+		_mm_storeu_si128((__m128i *) (out + i), fir_pack_sse2(acc0, acc1));
+		_mm_storeu_si128((__m128i *) (out + i + 8), fir_pack_sse2(acc2, acc3));
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm_storeu_si128((__m128i *) (out + i), fir_taps_sse2(kernel, x + i, taps));
+	}
+
+	fir_block_scalar(cnv, x + i, out + i, count - i);
+}
+
+TARGET_AVX2 static _inline __m256i fir_pack_avx2(__m256i lo, __m256i hi)
+{
+	lo = _mm256_srai_epi32(_mm256_slli_epi32(lo, 1), 16);
+	hi = _mm256_srai_epi32(_mm256_slli_epi32(hi, 1), 16);
+	return _mm256_packs_epi32(lo, hi);
+}
+
+TARGET_AVX2 static void fir_block_avx2(const iqconverter_int16_t *cnv, const int16_t *x, int16_t *out, int count)
+{
+	int i, t;
+	int taps = (cnv->len + 1) & ~1;
+	const int16_t *kernel = cnv->fir_kernel;
+	const int16_t *p;
+	__m256i a, b, c, acc0, acc1, acc2, acc3;
+
+	for (i = 0; i + 32 <= count; i += 32)
+	{
+		p = x + i;
+		acc0 = acc1 = acc2 = acc3 = _mm256_setzero_si256();
+
+		for (t = 0; t < taps; t += 2)
 		{
-			fir_index = cnv->len * (SIZE_FACTOR - 1);
-			memcpy(cnv->fir_queue + fir_index + 1, cnv->fir_queue, (cnv->len - 1) * sizeof(int32_t));
+			c = _mm256_set1_epi32(fir_tap_pair(kernel + t));
+			a = _mm256_loadu_si256((const __m256i *) (p + t));
+			b = _mm256_loadu_si256((const __m256i *) (p + t + 1));
+			acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), c));
+			acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), c));
+			a = _mm256_loadu_si256((const __m256i *) (p + t + 16));
+			b = _mm256_loadu_si256((const __m256i *) (p + t + 17));
+			acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), c));
+			acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), c));
 		}
 
-		samples[i] = acc >> 15;
+		_mm256_storeu_si256((__m256i *) (out + i), fir_pack_avx2(acc0, acc1));
+		_mm256_storeu_si256((__m256i *) (out + i + 16), fir_pack_avx2(acc2, acc3));
 	}
 
-	cnv->fir_index = fir_index;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm_storeu_si128((__m128i *) (out + i), fir_taps_sse2(kernel, x + i, taps));
+	}
+
+	fir_block_scalar(cnv, x + i, out + i, count - i);
 }
 
-static void delay_interleaved(iqconverter_int16_t *cnv, int16_t *samples, int len)
+#ifdef CPU_FEATURES_X86_AVX512
+
+TARGET_AVX512 static _inline __m512i fir_pack_avx512(__m512i lo, __m512i hi)
 {
-	int i;
-	int index;
-	int half_len;
-	int16_t res;
-	
-	half_len = cnv->len >> 1;
-	index = cnv->delay_index;
+	lo = _mm512_srai_epi32(_mm512_slli_epi32(lo, 1), 16);
+	hi = _mm512_srai_epi32(_mm512_slli_epi32(hi, 1), 16);
+	return _mm512_packs_epi32(lo, hi);
+}
+
+TARGET_AVX512 static void fir_block_avx512(const iqconverter_int16_t *cnv, const int16_t *x, int16_t *out, int count)
+{
+	int i, t;
+	int taps = (cnv->len + 1) & ~1;
+	const int16_t *kernel = cnv->fir_kernel;
+	const int16_t *p;
+	__m512i a, b, c, acc0, acc1, acc2, acc3;
 
-	for (i = 0; i < len; i += 2)
+	for (i = 0; i + 64 <= count; i += 64)
 	{
-		res = cnv->delay_line[index];
-		cnv->delay_line[index] = samples[i];
-		samples[i] = res;
+		p = x + i;
+		acc0 = acc1 = acc2 = acc3 = _mm512_setzero_si512();
 
-		if (++index >= half_len)
+		for (t = 0; t < taps; t += 2)
 		{
-			index = 0;
+			c = _mm512_set1_epi32(fir_tap_pair(kernel + t));
+			a = _mm512_loadu_si512((const void *) (p + t));
+			b = _mm512_loadu_si512((const void *) (p + t + 1));
+			acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_unpacklo_epi16(a, b), c));
+			acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(_mm512_unpackhi_epi16(a, b), c));
+			a = _mm512_loadu_si512((const void *) (p + t + 32));
+			b = _mm512_loadu_si512((const void *) (p + t + 33));
+			acc2 = _mm512_add_epi32(acc2, _mm512_madd_epi16(_mm512_unpacklo_epi16(a, b), c));
+			acc3 = _mm512_add_epi32(acc3, _mm512_madd_epi16(_mm512_unpackhi_epi16(a, b), c));
 		}
+
+		_mm512_storeu_si512((void *) (out + i), fir_pack_avx512(acc0, acc1));
+		_mm512_storeu_si512((void *) (out + i + 32), fir_pack_avx512(acc2, acc3));
+	}
+
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm_storeu_si128((__m128i *) (out + i), fir_taps_sse2(kernel, x + i, taps));
+	}
+
+	fir_block_scalar(cnv, x + i, out + i, count - i);
+}
+
+#endif
+
+#endif
+
+/*
+ * The converter runs one tile of FIR_BLOCK_SIZE pairs at a time through
+ * all stages so the data stays in L1. split() applies the fs/4 rotation
+ * while separating the even lanes into the FIR history and the odd lanes
+ * into the delay line, merge() interleaves the FIR output with the odd
+ * lanes delayed by len / 2. Both follow the pair phase from the start of
+ * the buffer, which stays aligned as tiles hold an even number of pairs.
+ */
+static void split_scalar(int16_t *even, int16_t *odd, const int16_t *samples, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (i & 1)
+		{
+			even[i] = samples[i * 2];
+			odd[i] = samples[i * 2 + 1] >> 1;
+		}
+		else
+		{
+			even[i] = -samples[i * 2];
+			odd[i] = -samples[i * 2 + 1] >> 1;
+		}
+	}
+}
+
+static void merge_scalar(int16_t *samples, const int16_t *even, const int16_t *odd, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		samples[i * 2] = even[i];
+		samples[i * 2 + 1] = odd[i];
+	}
+}
+
+#ifdef CPU_FEATURES_X86
+
+/*
+ * With m = -1 on the even pairs, (x ^ m) - m negates them with the same
+ * wrap-around as the scalar code and (x >> 1) - (x & m) gives (-x) >> 1
+ * without overflowing for x = -32768.
+ */
+TARGET_SSE2 static void split_sse2(int16_t *even, int16_t *odd, const int16_t *samples, int count)
+{
+	int i;
+	__m128i a, b, e, o;
+	const __m128i m = _mm_set1_epi32(0x0000ffff);
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		a = _mm_loadu_si128((const __m128i *) (samples + i * 2));
+		b = _mm_loadu_si128((const __m128i *) (samples + i * 2 + 8));
+		e = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+		o = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+		e = _mm_sub_epi16(_mm_xor_si128(e, m), m);
+		o = _mm_sub_epi16(_mm_srai_epi16(o, 1), _mm_and_si128(o, m));
+		_mm_storeu_si128((__m128i *) (even + i), e);
+		_mm_storeu_si128((__m128i *) (odd + i), o);
+	}
+
+	split_scalar(even + i, odd + i, samples + i * 2, count - i);
+}
+
+TARGET_SSE2 static void merge_sse2(int16_t *samples, const int16_t *even, const int16_t *odd, int count)
+{
+	int i;
+	__m128i e, o;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		e = _mm_loadu_si128((const __m128i *) (even + i));
+		o = _mm_loadu_si128((const __m128i *) (odd + i));
+		_mm_storeu_si128((__m128i *) (samples + i * 2), _mm_unpacklo_epi16(e, o));
+		_mm_storeu_si128((__m128i *) (samples + i * 2 + 8), _mm_unpackhi_epi16(e, o));
+	}
+
+	merge_scalar(samples + i * 2, even + i, odd + i, count - i);
+}
+
+TARGET_AVX2 static void split_avx2(int16_t *even, int16_t *odd, const int16_t *samples, int count)
+{
+	int i;
+	__m256i a, b, e, o;
+	const __m256i m = _mm256_set1_epi32(0x0000ffff);
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		a = _mm256_loadu_si256((const __m256i *) (samples + i * 2));
+		b = _mm256_loadu_si256((const __m256i *) (samples + i * 2 + 16));
+		e = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16), _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16));
+		o = _mm256_packs_epi32(_mm256_srai_epi32(a, 16), _mm256_srai_epi32(b, 16));
+		e = _mm256_permute4x64_epi64(e, _MM_SHUFFLE(3, 1, 2, 0));
+		o = _mm256_permute4x64_epi64(o, _MM_SHUFFLE(3, 1, 2, 0));
+		e = _mm256_sub_epi16(_mm256_xor_si256(e, m), m);
+		o = _mm256_sub_epi16(_mm256_srai_epi16(o, 1), _mm256_and_si256(o, m));
+		_mm256_storeu_si256((__m256i *) (even + i), e);
+		_mm256_storeu_si256((__m256i *) (odd + i), o);
+	}
+
+	split_scalar(even + i, odd + i, samples + i * 2, count - i);
+}
+
+TARGET_AVX2 static void merge_avx2(int16_t *samples, const int16_t *even, const int16_t *odd, int count)
+{
+	int i;
+	__m256i e, o, lo, hi;
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		e = _mm256_loadu_si256((const __m256i *) (even + i));
+		o = _mm256_loadu_si256((const __m256i *) (odd + i));
+		lo = _mm256_unpacklo_epi16(e, o);
+		hi = _mm256_unpackhi_epi16(e, o);
+		_mm256_storeu_si256((__m256i *) (samples + i * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *) (samples + i * 2 + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
 	}
-	
-	cnv->delay_index = index;
+
+	merge_scalar(samples + i * 2, even + i, odd + i, count - i);
 }
 
+#endif
+
 static void remove_dc(iqconverter_int16_t *cnv, int16_t *samples, int len)
 {
 	int i;
@@ -182,24 +489,209 @@ static void remove_dc(iqconverter_int16_t *cnv, int16_t *samples, int len)
 	cnv->old_e = old_e;
 }
 
-static void translate_fs_4(iqconverter_int16_t *cnv, int16_t *samples, int len)
+void iqconverter_int16_init(uint32_t cpu_features)
 {
-	int i;
+	iqconverter_int16_kernels_t selected;
+
+	selected.fir = fir_block_scalar;
+	selected.split = split_scalar;
+	selected.merge = merge_scalar;
+	selected.fir_variant = "scalar";
+	selected.split_variant = "scalar";
+
+#ifdef CPU_FEATURES_X86
+#ifdef CPU_FEATURES_X86_AVX512
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX512))
+	{
+		selected.fir = fir_block_avx512;
+		selected.fir_variant = "avx512";
+	}
+	else
+#endif
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX2))
+	{
+		selected.fir = fir_block_avx2;
+		selected.fir_variant = "avx2";
+	}
+	else if (CPU_HAS(cpu_features, CPU_FEATURE_SSE2))
+	{
+		selected.fir = fir_block_sse2;
+		selected.fir_variant = "sse2";
+	}
+
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX2))
+	{
+		selected.split = split_avx2;
+		selected.merge = merge_avx2;
+		selected.split_variant = "avx2";
+	}
+	else if (CPU_HAS(cpu_features, CPU_FEATURE_SSE2))
+	{
+		selected.split = split_sse2;
+		selected.merge = merge_sse2;
+		selected.split_variant = "sse2";
+	}
+#endif
+
+	kernels = selected;
+}
 
-	for (i = 0; i < len; i += 4)
+const char *iqconverter_int16_variant(const iqconverter_int16_t *cnv, int kernel)
+{
+	(void) cnv;
+
+	switch (kernel)
+	{
+	case DSP_KERNEL_REMOVE_DC:
+		return "scalar";
+
+	case DSP_KERNEL_TRANSLATE:
+	case DSP_KERNEL_DELAY:
+		return kernels.split_variant;
+
+	case DSP_KERNEL_FIR:
+		return kernels.fir_variant;
+
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * One tile of count pairs through the FIR and the delay line. A NULL
+ * output only shifts the samples into the history.
+ */
+static void filter_tile(iqconverter_int16_t *cnv, int16_t *samples, const int16_t *input, int count)
+{
+	int history = cnv->len - 1;
+	int delay = cnv->len >> 1;
+	int16_t *fir_queue = cnv->fir_queue;
+	int16_t *delay_line = cnv->delay_line;
+
+	kernels.split(fir_queue + history, delay_line + delay, input, count);
+	if (samples != NULL)
 	{
-		samples[i + 0] = -samples[i + 0];
-		samples[i + 1] = -samples[i + 1] >> 1;
-		//samples[i + 2] = samples[i + 2];
-		samples[i + 3] = samples[i + 3] >> 1;
+		kernels.fir(cnv, fir_queue, fir_queue, count);
+		kernels.merge(samples, fir_queue, delay_line, count);
 	}
 
-	fir_interleaved(cnv, samples, len);
-	delay_interleaved(cnv, samples + 1, len);
+	memmove(fir_queue, fir_queue + count, history * sizeof(int16_t));
+	memmove(delay_line, delay_line + count, delay * sizeof(int16_t));
 }
 
 void iqconverter_int16_process(iqconverter_int16_t *cnv, int16_t *samples, int len)
 {
-	remove_dc(cnv, samples, len);
-	translate_fs_4(cnv, samples, len);
+	int i, count;
+
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		remove_dc(cnv, samples + i, count * 2);
+		filter_tile(cnv, samples + i, samples + i, count);
+	}
+}
+
+void iqconverter_int16_remove_dc(iqconverter_int16_t *cnv, int16_t *samples, int len)
+{
+	int i, count;
+
+	// Same segmentation as iqconverter_int16_process()
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		remove_dc(cnv, samples + i, count * 2);
+	}
+}
+
+int iqconverter_int16_history_size(const iqconverter_int16_t *cnv)
+{
+	int history = cnv->len - 1;
+
+	// An even number of pairs so the fs/4 phase lines up with the chunk
+	return ((history + 1) & ~1) * 2;
+}
+
+/*
+ * Chunks start on a tile boundary so the tiles match process(), and past
+ * the filter history so each chunk can be seeded from the samples before
+ * it. Returns the number of chunks, bounds holds one more entry.
+ */
+int iqconverter_int16_split(const iqconverter_int16_t *cnv, int len, int max_chunks, int *bounds)
+{
+	int i;
+	int chunks;
+	int step;
+	int unit = IQCONVERTER_INT16_TILE_SIZE;
+
+	while (unit < iqconverter_int16_history_size(cnv))
+	{
+		unit += IQCONVERTER_INT16_TILE_SIZE;
+	}
+
+	chunks = len / unit;
+	if (chunks > max_chunks)
+	{
+		chunks = max_chunks;
+	}
+	if (chunks < 1)
+	{
+		chunks = 1;
+	}
+
+	step = (len / chunks) / unit * unit;
+	for (i = 0; i < chunks; i++)
+	{
+		bounds[i] = i * step;
+	}
+	bounds[chunks] = len;
+
+	return chunks;
+}
+
+void iqconverter_int16_load_history(iqconverter_int16_t *cnv, const int16_t *samples, int len)
+{
+	int i, count;
+
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		filter_tile(cnv, NULL, samples + i, count);
+	}
+}
+
+void iqconverter_int16_copy_history(iqconverter_int16_t *dst, const iqconverter_int16_t *src)
+{
+	memcpy(dst->fir_queue, src->fir_queue, (src->len - 1) * sizeof(int16_t));
+	memcpy(dst->delay_line, src->delay_line, (src->len >> 1) * sizeof(int16_t));
+}
+
+void iqconverter_int16_filter(iqconverter_int16_t *cnv, int16_t *samples, int len)
+{
+	int i, count;
+
+	for (i = 0; i + 1 < len; i += count * 2)
+	{
+		count = (len - i) / 2;
+		if (count > FIR_BLOCK_SIZE)
+		{
+			count = FIR_BLOCK_SIZE;
+		}
+
+		filter_tile(cnv, samples + i, samples + i, count);
+	}
 }
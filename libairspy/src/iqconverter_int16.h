@@ -25,21 +25,33 @@ THE SOFTWARE.
 
 #include <stdint.h>
 
+// Samples per processing tile
+#define IQCONVERTER_INT16_TILE_SIZE 512
+
 typedef struct {
 	int len;
-	int fir_index;
-	int delay_index;
 	int16_t old_x;
 	int16_t old_y;
 	int32_t old_e;
-	int32_t *fir_kernel;
-	int32_t *fir_queue;
+	int16_t *fir_kernel;
+	int16_t *fir_queue;
 	int16_t *delay_line;
 } iqconverter_int16_t;
 
+void iqconverter_int16_init(uint32_t cpu_features);
+const char *iqconverter_int16_variant(const iqconverter_int16_t *cnv, int kernel);
 iqconverter_int16_t *iqconverter_int16_create(const int16_t *hb_kernel, int len);
 void iqconverter_int16_free(iqconverter_int16_t *cnv);
 void iqconverter_int16_reset(iqconverter_int16_t *cnv);
 void iqconverter_int16_process(iqconverter_int16_t *cnv, int16_t *samples, int len);
 
+/* Split form of iqconverter_int16_process(), see iqconverter_float.h */
+iqconverter_int16_t *iqconverter_int16_clone(const iqconverter_int16_t *cnv);
+void iqconverter_int16_remove_dc(iqconverter_int16_t *cnv, int16_t *samples, int len);
+int iqconverter_int16_history_size(const iqconverter_int16_t *cnv);
+int iqconverter_int16_split(const iqconverter_int16_t *cnv, int len, int max_chunks, int *bounds);
+void iqconverter_int16_load_history(iqconverter_int16_t *cnv, const int16_t *samples, int len);
+void iqconverter_int16_copy_history(iqconverter_int16_t *dst, const iqconverter_int16_t *src);
+void iqconverter_int16_filter(iqconverter_int16_t *cnv, int16_t *samples, int len);
+
 #endif // IQCONVERTER_INT16_H
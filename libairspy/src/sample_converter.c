@@ -0,0 +1,382 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "sample_converter.h"
+#include "cpu_features.h"
+
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+#ifndef _MSC_VER
+	#define _inline inline
+#endif
+
+#define SAMPLE_RESOLUTION 12
+#define SAMPLE_ENCAPSULATION 16
+
+#define SAMPLE_SHIFT (SAMPLE_ENCAPSULATION - SAMPLE_RESOLUTION)
+#define SAMPLE_SCALE (1.0f / (1 << (15 - SAMPLE_SHIFT)))
+
+typedef struct {
+	void (*unpack)(const uint32_t *input, uint16_t *output, int length);
+	void (*convert_int16)(const uint16_t *src, int16_t *dest, int count);
+	void (*convert_float)(const uint16_t *src, float *dest, int count);
+	void (*unpack_convert_int16)(const uint32_t *input, int16_t *output, int length);
+	void (*unpack_convert_float)(const uint32_t *input, float *output, int length);
+	const char *convert_variant;
+	const char *unpack_variant;
+} sample_converter_kernels_t;
+
+static void convert_samples_int16_scalar(const uint16_t *src, int16_t *dest, int count);
+static void convert_samples_float_scalar(const uint16_t *src, float *dest, int count);
+static void unpack_convert_int16_scalar(const uint32_t *input, int16_t *output, int length);
+static void unpack_convert_float_scalar(const uint32_t *input, float *output, int length);
+
+static sample_converter_kernels_t kernels =
+{
+	unpack_samples_scalar,
+	convert_samples_int16_scalar,
+	convert_samples_float_scalar,
+	unpack_convert_int16_scalar,
+	unpack_convert_float_scalar,
+	"scalar",
+	"scalar"
+};
+
+static _inline void unpack_group(const uint32_t *input, uint16_t *output)
+{
+	output[0] = (input[0] >> 20) & 0xfff;
+	output[1] = (input[0] >> 8) & 0xfff;
+	output[2] = ((input[0] & 0xff) << 4) | ((input[1] >> 28) & 0xf);
+	output[3] = ((input[1] & 0xfff0000) >> 16);
+	output[4] = ((input[1] & 0xfff0) >> 4);
+	output[5] = ((input[1] & 0xf) << 8) | ((input[2] & 0xff000000) >> 24);
+	output[6] = ((input[2] >> 12) & 0xfff);
+	output[7] = ((input[2] & 0xfff));
+}
+
+void unpack_samples_scalar(const uint32_t *input, uint16_t *output, int length)
+{
+	int i, j;
+
+	for (i = 0, j = 0; j < length; i += 3, j += 8)
+	{
+		unpack_group(input + i, output + j);
+	}
+}
+
+static void convert_samples_int16_scalar(const uint16_t *src, int16_t *dest, int count)
+{
+	int i;
+	for (i = 0; i < count; i += 4)
+	{
+		dest[i + 0] = (src[i + 0] - 2048) << SAMPLE_SHIFT;
+		dest[i + 1] = (src[i + 1] - 2048) << SAMPLE_SHIFT;
+		dest[i + 2] = (src[i + 2] - 2048) << SAMPLE_SHIFT;
+		dest[i + 3] = (src[i + 3] - 2048) << SAMPLE_SHIFT;
+	}
+}
+
+static void convert_samples_float_scalar(const uint16_t *src, float *dest, int count)
+{
+	int i;
+	for (i = 0; i < count; i += 4)
+	{
+		dest[i + 0] = (src[i + 0] - 2048) * SAMPLE_SCALE;
+		dest[i + 1] = (src[i + 1] - 2048) * SAMPLE_SCALE;
+		dest[i + 2] = (src[i + 2] - 2048) * SAMPLE_SCALE;
+		dest[i + 3] = (src[i + 3] - 2048) * SAMPLE_SCALE;
+	}
+}
+
+static void unpack_convert_int16_scalar(const uint32_t *input, int16_t *output, int length)
+{
+	int i, j;
+	uint16_t unpacked[8];
+
+	for (i = 0, j = 0; j < length; i += 3, j += 8)
+	{
+		unpack_group(input + i, unpacked);
+		convert_samples_int16_scalar(unpacked, output + j, 8);
+	}
+}
+
+static void unpack_convert_float_scalar(const uint32_t *input, float *output, int length)
+{
+	int i, j;
+	uint16_t unpacked[8];
+
+	for (i = 0, j = 0; j < length; i += 3, j += 8)
+	{
+		unpack_group(input + i, unpacked);
+		convert_samples_float_scalar(unpacked, output + j, 8);
+	}
+}
+
+#ifdef CPU_FEATURES_X86
+
+/*
+ * Each group of 12 bytes holds 4 pairs of samples. For every pair the shuffle
+ * builds two 16bit lanes: the even sample sits in the upper 12 bits of its lane
+ * and the odd sample in the lower 12 bits of the next one.
+ *
+ * The packed samples are always 12bit wide, so ((x - 2048) << 4) is computed
+ * as ((x << 4) ^ 0x8000) and the float conversion reuses that int16 value.
+ */
+#define UNPACK_SHUFFLE 2, 3, 1, 2, 7, 0, 6, 7, 4, 5, 11, 4, 9, 10, 8, 9
+#define INT16_TO_FLOAT_SCALE (1.0f / 32768.0f)
+
+TARGET_SSSE3 static _inline __m128i unpack_group_ssse3(const uint32_t *input)
+{
+	const __m128i shuffle = _mm_setr_epi8(UNPACK_SHUFFLE);
+	const __m128i even_mask = _mm_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+	const __m128i odd_mask = _mm_setr_epi16(0, 0xfff, 0, 0xfff, 0, 0xfff, 0, 0xfff);
+	__m128i v;
+
+	v = _mm_loadu_si128((const __m128i *) input);
+	v = _mm_shuffle_epi8(v, shuffle);
+	return _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 4), even_mask), _mm_and_si128(v, odd_mask));
+}
+
+TARGET_SSSE3 static _inline __m128i center_int16_ssse3(__m128i v)
+{
+	return _mm_xor_si128(_mm_slli_epi16(v, SAMPLE_SHIFT), _mm_set1_epi16((short) 0x8000));
+}
+
+// 16 bytes are loaded for each 12 byte group, the last group is left to the scalar loop
+#define SSSE3_GROUP_FITS(i, length) ((i) * 4 + 16 <= (length) * 3 / 2)
+
+TARGET_SSSE3 static void unpack_samples_ssse3(const uint32_t *input, uint16_t *output, int length)
+{
+	int i, j;
+
+	for (i = 0, j = 0; SSSE3_GROUP_FITS(i, length); i += 3, j += 8)
+	{
+		_mm_storeu_si128((__m128i *) (output + j), unpack_group_ssse3(input + i));
+	}
+
+	unpack_samples_scalar(input + i, output + j, length - j);
+}
+
+TARGET_SSSE3 static void unpack_convert_int16_ssse3(const uint32_t *input, int16_t *output, int length)
+{
+	int i, j;
+
+	for (i = 0, j = 0; SSSE3_GROUP_FITS(i, length); i += 3, j += 8)
+	{
+		_mm_storeu_si128((__m128i *) (output + j), center_int16_ssse3(unpack_group_ssse3(input + i)));
+	}
+
+	unpack_convert_int16_scalar(input + i, output + j, length - j);
+}
+
+TARGET_SSSE3 static void unpack_convert_float_ssse3(const uint32_t *input, float *output, int length)
+{
+	int i, j;
+	__m128i v;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(INT16_TO_FLOAT_SCALE);
+
+	for (i = 0, j = 0; SSSE3_GROUP_FITS(i, length); i += 3, j += 8)
+	{
+		v = center_int16_ssse3(unpack_group_ssse3(input + i));
+		_mm_storeu_ps(output + j, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(zero, v), 16)), scale));
+		_mm_storeu_ps(output + j + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(zero, v), 16)), scale));
+	}
+
+	unpack_convert_float_scalar(input + i, output + j, length - j);
+}
+
+// Two groups per iteration, the second one is moved to the upper 128bit lane
+TARGET_AVX2 static _inline __m256i unpack_groups_avx2(const uint32_t *input)
+{
+	const __m256i shuffle = _mm256_setr_epi8(UNPACK_SHUFFLE, UNPACK_SHUFFLE);
+	const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+	const __m256i even_mask = _mm256_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0);
+	const __m256i odd_mask = _mm256_setr_epi16(0, 0xfff, 0, 0xfff, 0, 0xfff, 0, 0xfff, 0, 0xfff, 0, 0xfff, 0, 0xfff, 0, 0xfff);
+	__m256i v;
+
+	v = _mm256_loadu_si256((const __m256i *) input);
+	v = _mm256_permutevar8x32_epi32(v, spread);
+	v = _mm256_shuffle_epi8(v, shuffle);
+	return _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(v, 4), even_mask), _mm256_and_si256(v, odd_mask));
+}
+
+TARGET_AVX2 static _inline __m256i center_int16_avx2(__m256i v)
+{
+	return _mm256_xor_si256(_mm256_slli_epi16(v, SAMPLE_SHIFT), _mm256_set1_epi16((short) 0x8000));
+}
+
+TARGET_AVX2 static _inline void store_int16_as_float_avx2(float *output, __m256i v, __m256 scale)
+{
+	_mm256_storeu_ps(output, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v))), scale));
+	_mm256_storeu_ps(output + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1))), scale));
+}
+
+#define AVX2_GROUPS_FIT(i, length) ((i) * 4 + 32 <= (length) * 3 / 2)
+
+TARGET_AVX2 static void unpack_samples_avx2(const uint32_t *input, uint16_t *output, int length)
+{
+	int i, j;
+
+	for (i = 0, j = 0; AVX2_GROUPS_FIT(i, length); i += 6, j += 16)
+	{
+		_mm256_storeu_si256((__m256i *) (output + j), unpack_groups_avx2(input + i));
+	}
+
+	unpack_samples_scalar(input + i, output + j, length - j);
+}
+
+TARGET_AVX2 static void unpack_convert_int16_avx2(const uint32_t *input, int16_t *output, int length)
+{
+	int i, j;
+
+	for (i = 0, j = 0; AVX2_GROUPS_FIT(i, length); i += 6, j += 16)
+	{
+		_mm256_storeu_si256((__m256i *) (output + j), center_int16_avx2(unpack_groups_avx2(input + i)));
+	}
+
+	unpack_convert_int16_scalar(input + i, output + j, length - j);
+}
+
+TARGET_AVX2 static void unpack_convert_float_avx2(const uint32_t *input, float *output, int length)
+{
+	int i, j;
+	const __m256 scale = _mm256_set1_ps(INT16_TO_FLOAT_SCALE);
+
+	for (i = 0, j = 0; AVX2_GROUPS_FIT(i, length); i += 6, j += 16)
+	{
+		store_int16_as_float_avx2(output + j, center_int16_avx2(unpack_groups_avx2(input + i)), scale);
+	}
+
+	unpack_convert_float_scalar(input + i, output + j, length - j);
+}
+
+TARGET_AVX2 static void convert_samples_int16_avx2(const uint16_t *src, int16_t *dest, int count)
+{
+	int i;
+	__m256i v;
+	const __m256i offset = _mm256_set1_epi16((short) 0x8000);
+
+	// (x - 2048) << 4 wraps to the same 16 bits as (x << 4) ^ 0x8000 for any x
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		v = _mm256_loadu_si256((const __m256i *) (src + i));
+		_mm256_storeu_si256((__m256i *) (dest + i), _mm256_xor_si256(_mm256_slli_epi16(v, SAMPLE_SHIFT), offset));
+	}
+
+	convert_samples_int16_scalar(src + i, dest + i, count - i);
+}
+
+TARGET_AVX2 static void convert_samples_float_avx2(const uint16_t *src, float *dest, int count)
+{
+	int i;
+	__m256i v;
+	const __m256i offset = _mm256_set1_epi32(2048);
+	const __m256 scale = _mm256_set1_ps(SAMPLE_SCALE);
+
+	for (i = 0; i + 16 <= count; i += 16)
+	{
+		v = _mm256_loadu_si256((const __m256i *) (src + i));
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)), offset)), scale));
+		_mm256_storeu_ps(dest + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)), offset)), scale));
+	}
+
+	convert_samples_float_scalar(src + i, dest + i, count - i);
+}
+
+#endif
+
+void sample_converter_init(uint32_t cpu_features)
+{
+	sample_converter_kernels_t selected;
+
+	selected.unpack = unpack_samples_scalar;
+	selected.convert_int16 = convert_samples_int16_scalar;
+	selected.convert_float = convert_samples_float_scalar;
+	selected.unpack_convert_int16 = unpack_convert_int16_scalar;
+	selected.unpack_convert_float = unpack_convert_float_scalar;
+	selected.convert_variant = "scalar";
+	selected.unpack_variant = "scalar";
+
+#ifdef CPU_FEATURES_X86
+	if (CPU_HAS(cpu_features, CPU_FEATURE_AVX2))
+	{
+		selected.unpack = unpack_samples_avx2;
+		selected.convert_int16 = convert_samples_int16_avx2;
+		selected.convert_float = convert_samples_float_avx2;
+		selected.unpack_convert_int16 = unpack_convert_int16_avx2;
+		selected.unpack_convert_float = unpack_convert_float_avx2;
+		selected.convert_variant = "avx2";
+		selected.unpack_variant = "avx2";
+	}
+	else if (CPU_HAS(cpu_features, CPU_FEATURE_SSSE3))
+	{
+		selected.unpack = unpack_samples_ssse3;
+		selected.unpack_convert_int16 = unpack_convert_int16_ssse3;
+		selected.unpack_convert_float = unpack_convert_float_ssse3;
+		selected.unpack_variant = "ssse3";
+	}
+#endif
+
+	kernels = selected;
+}
+
+const char *sample_converter_variant(int kernel)
+{
+	switch (kernel)
+	{
+	case DSP_KERNEL_UNPACK:
+		return kernels.unpack_variant;
+
+	case DSP_KERNEL_CONVERT:
+		return kernels.convert_variant;
+
+	default:
+		return NULL;
+	}
+}
+
+void unpack_samples(const uint32_t *input, uint16_t *output, int length)
+{
+	kernels.unpack(input, output, length);
+}
+
+void convert_samples_int16(const uint16_t *src, int16_t *dest, int count)
+{
+	kernels.convert_int16(src, dest, count);
+}
+
+void convert_samples_float(const uint16_t *src, float *dest, int count)
+{
+	kernels.convert_float(src, dest, count);
+}
+
+void unpack_convert_int16(const uint32_t *input, int16_t *output, int length)
+{
+	kernels.unpack_convert_int16(input, output, length);
+}
+
+void unpack_convert_float(const uint32_t *input, float *output, int length)
+{
+	kernels.unpack_convert_float(input, output, length);
+}
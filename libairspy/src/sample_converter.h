@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SAMPLE_CONVERTER_H
+#define SAMPLE_CONVERTER_H
+
+#include <stdint.h>
+
+void sample_converter_init(uint32_t cpu_features);
+/* Name of the implementation bound to a dsp_kernel_t, NULL for kernels outside of this module */
+const char *sample_converter_variant(int kernel);
+
+/* Expands 3 packed 32bit words into 8 12bit samples, length is the number of output samples (multiple of 8) */
+void unpack_samples(const uint32_t *input, uint16_t *output, int length);
+void unpack_samples_scalar(const uint32_t *input, uint16_t *output, int length);
+
+/* Centers 12bit samples around 0 and scales them, count shall be a multiple of 4 */
+void convert_samples_int16(const uint16_t *src, int16_t *dest, int count);
+void convert_samples_float(const uint16_t *src, float *dest, int count);
+
+/* Single pass unpack + convert of packed samples, length is the number of output samples (multiple of 8) */
+void unpack_convert_int16(const uint32_t *input, int16_t *output, int length);
+void unpack_convert_float(const uint32_t *input, float *output, int length);
+
+#endif // SAMPLE_CONVERTER_H
@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "thread_sched.h"
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#define MAX_NUMA_NODES 64
+
+unsigned int thread_sched_cpu_count(void)
+{
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return count > 0 ? (unsigned int) count : 1;
+#endif
+}
+
+int thread_sched_mask_node(uint64_t cpu_mask)
+{
+	int cpu;
+
+	if (cpu_mask == 0)
+	{
+		return -1;
+	}
+
+	for (cpu = 0; !(cpu_mask & ((uint64_t) 1 << cpu)); cpu++)
+	{
+	}
+
+#if defined(_WIN32)
+	{
+		UCHAR node;
+
+		return GetNumaProcessorNode((UCHAR) cpu, &node) && node != 0xFF ? node : -1;
+	}
+#elif defined(__linux__)
+	{
+		int node;
+		char path[64];
+
+		// sysfs links each CPU to its node
+		for (node = 0; node < MAX_NUMA_NODES; node++)
+		{
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+			if (access(path, F_OK) == 0)
+			{
+				return node;
+			}
+		}
+
+		return -1;
+	}
+#else
+	return -1;
+#endif
+}
+
+int thread_sched_apply(const thread_sched_t *sched)
+{
+	int result = 0;
+
+#if defined(_WIN32)
+	if (sched->cpu_mask != 0)
+	{
+		if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) sched->cpu_mask) == 0)
+		{
+			result = -1;
+		}
+	}
+
+	if (!SetThreadPriority(GetCurrentThread(), sched->policy != THREAD_SCHED_DEFAULT ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST))
+	{
+		result = -1;
+	}
+#else
+	struct sched_param param;
+#if defined(__linux__)
+	int cpu;
+	cpu_set_t cpus;
+
+	if (sched->cpu_mask != 0)
+	{
+		CPU_ZERO(&cpus);
+		for (cpu = 0; cpu < 64; cpu++)
+		{
+			if (sched->cpu_mask & ((uint64_t) 1 << cpu))
+			{
+				CPU_SET(cpu, &cpus);
+			}
+		}
+		if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+		{
+			result = -1;
+		}
+	}
+#else
+	// No thread affinity on macOS and the BSDs
+	if (sched->cpu_mask != 0)
+	{
+		result = -1;
+	}
+#endif
+
+	// Needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance on Linux
+	if (sched->policy != THREAD_SCHED_DEFAULT)
+	{
+		param.sched_priority = sched->priority;
+		if (pthread_setschedparam(pthread_self(), sched->policy == THREAD_SCHED_RR ? SCHED_RR : SCHED_FIFO, &param) != 0)
+		{
+			result = -1;
+		}
+	}
+#endif
+
+	return result;
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef THREAD_SCHED_H
+#define THREAD_SCHED_H
+
+#include <stdint.h>
+
+/* Same values as enum airspy_sched_policy */
+#define THREAD_SCHED_DEFAULT 0
+#define THREAD_SCHED_FIFO 1
+#define THREAD_SCHED_RR 2
+
+typedef struct {
+	uint64_t cpu_mask; // CPUs 0 to 63, 0 for no affinity
+	int policy;
+	int priority;      // 1 to 99 for THREAD_SCHED_FIFO / THREAD_SCHED_RR
+} thread_sched_t;
+
+/*
+ * Applies to the calling thread. Real time policies map to
+ * THREAD_PRIORITY_TIME_CRITICAL on Windows, where the default stays the
+ * THREAD_PRIORITY_HIGHEST of the library's streaming threads. Best
+ * effort, returns 0 when everything asked for was applied.
+ */
+int thread_sched_apply(const thread_sched_t *sched);
+
+/* Online logical processors */
+unsigned int thread_sched_cpu_count(void);
+/* NUMA node of the lowest CPU in cpu_mask, -1 when unknown */
+int thread_sched_mask_node(uint64_t cpu_mask);
+
+#endif // THREAD_SCHED_H
@@ -0,0 +1,435 @@
+/*
+Copyright (c) 2026, libairspy contributors
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+		Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+		Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the
+		documentation and/or other materials provided with the distribution.
+		Neither the name of AirSpy nor the names of its contributors may be used to endorse or promote products derived from this software
+		without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Checks the promises the DSP kernels make, for every kernel set the CPU
+ * supports:
+ *   - sample conversion and the int16 FIR are bit-identical to the scalar code
+ *   - float kernels stay within rounding of the scalar code
+ *   - int16 DC removal is bit-identical to the scalar code, also at full scale
+ *   - process() is bit-identical to the chunks of iqconverter_*_split() as
+ *     converted by airspy_set_conversion_threads()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "cpu_features.h"
+#include "sample_converter.h"
+#include "iqconverter_float.h"
+#include "iqconverter_int16.h"
+#include "filters.h"
+
+#define SAMPLE_COUNT 16384 // Real samples per buffer
+#define BUFFER_COUNT 4
+#define MAX_CHUNKS 8
+#define FLOAT_TOLERANCE 1e-5f
+
+static const uint32_t kernel_sets[] =
+{
+	0,
+	CPU_FEATURE_SSE2,
+	CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41,
+	CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41 | CPU_FEATURE_AVX2_FMA,
+	CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41 | CPU_FEATURE_AVX2_FMA | CPU_FEATURE_AVX512
+};
+
+#define KERNEL_SET_COUNT (sizeof(kernel_sets) / sizeof(kernel_sets[0]))
+
+static const int chunk_counts[] = { 2, 3, 4, 7 };
+
+#define CHUNK_COUNT_COUNT (sizeof(chunk_counts) / sizeof(chunk_counts[0]))
+
+static int failures;
+static uint32_t random_state = 0x2545f491;
+
+static uint32_t next_random(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+static void report(int ok, const char *what, uint32_t kernel_set)
+{
+	printf("%-52s set 0x%02x: %s\n", what, kernel_set, ok ? "ok" : "FAILED");
+	if (!ok)
+	{
+		failures++;
+	}
+}
+
+static int same_float(const float *a, const float *b, int len, float tolerance)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+	{
+		if (fabsf(a[i] - b[i]) > tolerance)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// Half-band layout: taps on the even indices and the center
+static void make_float_kernel(float *kernel, int len, int symmetric)
+{
+	int i;
+
+	memset(kernel, 0, len * sizeof(float));
+	for (i = 0; i <= len / 2; i += 2)
+	{
+		kernel[i] = ((int) (next_random() % 2001) - 1000) / 20000.0f;
+		kernel[len - 1 - i] = symmetric ? kernel[i] : ((int) (next_random() % 2001) - 1000) / 20000.0f;
+	}
+	kernel[len / 2] = 0.5f;
+}
+
+static void make_int16_kernel(int16_t *kernel, int len, int symmetric)
+{
+	int i;
+
+	memset(kernel, 0, len * sizeof(int16_t));
+	for (i = 0; i <= len / 2; i += 2)
+	{
+		kernel[i] = (int16_t) ((int) (next_random() % 4001) - 2000);
+		kernel[len - 1 - i] = symmetric ? kernel[i] : (int16_t) ((int) (next_random() % 4001) - 2000);
+	}
+	kernel[len / 2] = 16384;
+}
+
+static void check_sample_converter(uint32_t kernel_set, const uint16_t *raw, const uint32_t *packed)
+{
+	static int16_t ref_i[SAMPLE_COUNT], out_i[SAMPLE_COUNT];
+	static float ref_f[SAMPLE_COUNT], out_f[SAMPLE_COUNT];
+	static uint16_t ref_u[SAMPLE_COUNT], out_u[SAMPLE_COUNT];
+	static int16_t ref_pi[SAMPLE_COUNT], out_pi[SAMPLE_COUNT];
+	static float ref_pf[SAMPLE_COUNT], out_pf[SAMPLE_COUNT];
+
+	sample_converter_init(0);
+	convert_samples_int16(raw, ref_i, SAMPLE_COUNT);
+	convert_samples_float(raw, ref_f, SAMPLE_COUNT);
+	unpack_samples(packed, ref_u, SAMPLE_COUNT);
+	unpack_convert_int16(packed, ref_pi, SAMPLE_COUNT);
+	unpack_convert_float(packed, ref_pf, SAMPLE_COUNT);
+
+	sample_converter_init(kernel_set);
+	convert_samples_int16(raw, out_i, SAMPLE_COUNT);
+	convert_samples_float(raw, out_f, SAMPLE_COUNT);
+	unpack_samples(packed, out_u, SAMPLE_COUNT);
+	unpack_convert_int16(packed, out_pi, SAMPLE_COUNT);
+	unpack_convert_float(packed, out_pf, SAMPLE_COUNT);
+
+	report(memcmp(ref_i, out_i, sizeof(ref_i)) == 0, "convert_samples_int16 == scalar", kernel_set);
+	report(memcmp(ref_f, out_f, sizeof(ref_f)) == 0, "convert_samples_float == scalar", kernel_set);
+	report(memcmp(ref_u, out_u, sizeof(ref_u)) == 0, "unpack_samples == scalar", kernel_set);
+	report(memcmp(ref_pi, out_pi, sizeof(ref_pi)) == 0, "unpack_convert_int16 == scalar", kernel_set);
+	report(memcmp(ref_pf, out_pf, sizeof(ref_pf)) == 0, "unpack_convert_float == scalar", kernel_set);
+}
+
+// Chunked conversion as done by convert_iq_parallel() in airspy.c, output shall match process()
+static int check_float_chunks(const float *kernel, int len, const float *input, int threads)
+{
+	int i, b, chunks, history;
+	int bounds[MAX_CHUNKS + 1];
+	int ok = 1;
+	static float ref[SAMPLE_COUNT], out[SAMPLE_COUNT];
+	iqconverter_float_t *single = iqconverter_float_create(kernel, len);
+	iqconverter_float_t *cnv = iqconverter_float_create(kernel, len);
+	iqconverter_float_t *workers[MAX_CHUNKS];
+
+	for (i = 0; i < threads; i++)
+	{
+		workers[i] = iqconverter_float_clone(cnv);
+	}
+
+	for (b = 0; b < BUFFER_COUNT; b++)
+	{
+		memcpy(ref, input + b * SAMPLE_COUNT, sizeof(ref));
+		memcpy(out, input + b * SAMPLE_COUNT, sizeof(out));
+		iqconverter_float_process(single, ref, SAMPLE_COUNT);
+
+		history = iqconverter_float_history_size(cnv);
+		chunks = iqconverter_float_split(cnv, SAMPLE_COUNT, threads, bounds);
+		if (history > SAMPLE_COUNT)
+		{
+			history = SAMPLE_COUNT;
+		}
+
+		iqconverter_float_remove_dc(cnv, out, SAMPLE_COUNT);
+		iqconverter_float_copy_history(workers[0], cnv);
+		for (i = 1; i < chunks; i++)
+		{
+			iqconverter_float_load_history(workers[i], out + bounds[i] - history, history);
+		}
+		iqconverter_float_load_history(cnv, out + SAMPLE_COUNT - history, history);
+
+		for (i = 0; i < chunks; i++)
+		{
+			iqconverter_float_filter(workers[i], out + bounds[i], bounds[i + 1] - bounds[i]);
+		}
+
+		ok = ok && memcmp(ref, out, sizeof(ref)) == 0;
+	}
+
+	for (i = 0; i < threads; i++)
+	{
+		iqconverter_float_free(workers[i]);
+	}
+	iqconverter_float_free(cnv);
+	iqconverter_float_free(single);
+
+	return ok;
+}
+
+static int check_int16_chunks(const int16_t *kernel, int len, const int16_t *input, int threads)
+{
+	int i, b, chunks, history;
+	int bounds[MAX_CHUNKS + 1];
+	int ok = 1;
+	static int16_t ref[SAMPLE_COUNT], out[SAMPLE_COUNT];
+	iqconverter_int16_t *single = iqconverter_int16_create(kernel, len);
+	iqconverter_int16_t *cnv = iqconverter_int16_create(kernel, len);
+	iqconverter_int16_t *workers[MAX_CHUNKS];
+
+	for (i = 0; i < threads; i++)
+	{
+		workers[i] = iqconverter_int16_clone(cnv);
+	}
+
+	for (b = 0; b < BUFFER_COUNT; b++)
+	{
+		memcpy(ref, input + b * SAMPLE_COUNT, sizeof(ref));
+		memcpy(out, input + b * SAMPLE_COUNT, sizeof(out));
+		iqconverter_int16_process(single, ref, SAMPLE_COUNT);
+
+		history = iqconverter_int16_history_size(cnv);
+		chunks = iqconverter_int16_split(cnv, SAMPLE_COUNT, threads, bounds);
+		if (history > SAMPLE_COUNT)
+		{
+			history = SAMPLE_COUNT;
+		}
+
+		iqconverter_int16_remove_dc(cnv, out, SAMPLE_COUNT);
+		iqconverter_int16_copy_history(workers[0], cnv);
+		for (i = 1; i < chunks; i++)
+		{
+			iqconverter_int16_load_history(workers[i], out + bounds[i] - history, history);
+		}
+		iqconverter_int16_load_history(cnv, out + SAMPLE_COUNT - history, history);
+
+		for (i = 0; i < chunks; i++)
+		{
+			iqconverter_int16_filter(workers[i], out + bounds[i], bounds[i + 1] - bounds[i]);
+		}
+
+		ok = ok && memcmp(ref, out, sizeof(ref)) == 0;
+	}
+
+	for (i = 0; i < threads; i++)
+	{
+		iqconverter_int16_free(workers[i]);
+	}
+	iqconverter_int16_free(cnv);
+	iqconverter_int16_free(single);
+
+	return ok;
+}
+
+// Runs remove_dc() over input, then filter() over filter_in (which may be dc_out),
+// with the kernels bound to kernel_set
+static void run_float(uint32_t kernel_set, const float *kernel, int len, const float *input, float *dc_out, const float *filter_in, float *filter_out)
+{
+	int b;
+	iqconverter_float_t *dc;
+	iqconverter_float_t *fir;
+
+	iqconverter_float_init(kernel_set);
+	dc = iqconverter_float_create(kernel, len);
+	fir = iqconverter_float_create(kernel, len);
+
+	memcpy(dc_out, input, BUFFER_COUNT * SAMPLE_COUNT * sizeof(float));
+	for (b = 0; b < BUFFER_COUNT; b++)
+	{
+		iqconverter_float_remove_dc(dc, dc_out + b * SAMPLE_COUNT, SAMPLE_COUNT);
+	}
+
+	memcpy(filter_out, filter_in, BUFFER_COUNT * SAMPLE_COUNT * sizeof(float));
+	for (b = 0; b < BUFFER_COUNT; b++)
+	{
+		iqconverter_float_filter(fir, filter_out + b * SAMPLE_COUNT, SAMPLE_COUNT);
+	}
+
+	iqconverter_float_free(fir);
+	iqconverter_float_free(dc);
+}
+
+static void run_int16(uint32_t kernel_set, const int16_t *kernel, int len, const int16_t *input, int16_t *dc_out, const int16_t *filter_in, int16_t *filter_out)
+{
+	int b;
+	iqconverter_int16_t *dc;
+	iqconverter_int16_t *fir;
+
+	iqconverter_int16_init(kernel_set);
+	dc = iqconverter_int16_create(kernel, len);
+	fir = iqconverter_int16_create(kernel, len);
+
+	memcpy(dc_out, input, BUFFER_COUNT * SAMPLE_COUNT * sizeof(int16_t));
+	for (b = 0; b < BUFFER_COUNT; b++)
+	{
+		iqconverter_int16_remove_dc(dc, dc_out + b * SAMPLE_COUNT, SAMPLE_COUNT);
+	}
+
+	memcpy(filter_out, filter_in, BUFFER_COUNT * SAMPLE_COUNT * sizeof(int16_t));
+	for (b = 0; b < BUFFER_COUNT; b++)
+	{
+		iqconverter_int16_filter(fir, filter_out + b * SAMPLE_COUNT, SAMPLE_COUNT);
+	}
+
+	iqconverter_int16_free(fir);
+	iqconverter_int16_free(dc);
+}
+
+static void check_float(uint32_t kernel_set, const float *kernel, int len, const float *input, const char *name)
+{
+	static float ref_dc[BUFFER_COUNT * SAMPLE_COUNT], ref_fir[BUFFER_COUNT * SAMPLE_COUNT];
+	static float dc[BUFFER_COUNT * SAMPLE_COUNT], fir[BUFFER_COUNT * SAMPLE_COUNT];
+	char what[64];
+	unsigned int i;
+	int ok = 1;
+
+	// Both filter() runs take the same input, the scalar DC removal output
+	run_float(0, kernel, len, input, ref_dc, ref_dc, ref_fir);
+	run_float(kernel_set, kernel, len, input, dc, ref_dc, fir);
+
+	snprintf(what, sizeof(what), "float remove_dc ~ scalar, %s", name);
+	report(same_float(ref_dc, dc, BUFFER_COUNT * SAMPLE_COUNT, FLOAT_TOLERANCE), what, kernel_set);
+	snprintf(what, sizeof(what), "float filter ~ scalar, %s", name);
+	report(same_float(ref_fir, fir, BUFFER_COUNT * SAMPLE_COUNT, FLOAT_TOLERANCE), what, kernel_set);
+
+	for (i = 0; i < CHUNK_COUNT_COUNT; i++)
+	{
+		ok = ok && check_float_chunks(kernel, len, input, chunk_counts[i]);
+	}
+	snprintf(what, sizeof(what), "float chunked == process, %s", name);
+	report(ok, what, kernel_set);
+}
+
+static void check_int16(uint32_t kernel_set, const int16_t *kernel, int len, const int16_t *input, const char *name)
+{
+	static int16_t ref_dc[BUFFER_COUNT * SAMPLE_COUNT], ref_fir[BUFFER_COUNT * SAMPLE_COUNT];
+	static int16_t dc[BUFFER_COUNT * SAMPLE_COUNT], fir[BUFFER_COUNT * SAMPLE_COUNT];
+	char what[64];
+	unsigned int i;
+	int ok = 1;
+
+	run_int16(0, kernel, len, input, ref_dc, ref_dc, ref_fir);
+	run_int16(kernel_set, kernel, len, input, dc, ref_dc, fir);
+
+	snprintf(what, sizeof(what), "int16 remove_dc == scalar, %s", name);
+	report(memcmp(ref_dc, dc, sizeof(dc)) == 0, what, kernel_set);
+	snprintf(what, sizeof(what), "int16 filter == scalar, %s", name);
+	report(memcmp(ref_fir, fir, sizeof(fir)) == 0, what, kernel_set);
+
+	for (i = 0; i < CHUNK_COUNT_COUNT; i++)
+	{
+		ok = ok && check_int16_chunks(kernel, len, input, chunk_counts[i]);
+	}
+	snprintf(what, sizeof(what), "int16 chunked == process, %s", name);
+	report(ok, what, kernel_set);
+}
+
+int main(void)
+{
+	unsigned int s;
+	int i;
+	uint32_t detected = cpu_features_detect();
+	uint32_t kernel_set;
+	static uint16_t raw[SAMPLE_COUNT];
+	static uint32_t packed[SAMPLE_COUNT * 3 / 8];
+	static float input_f[BUFFER_COUNT * SAMPLE_COUNT];
+	static int16_t input_i[BUFFER_COUNT * SAMPLE_COUNT];
+	static float full_f[BUFFER_COUNT * SAMPLE_COUNT];
+	static int16_t full_i[BUFFER_COUNT * SAMPLE_COUNT];
+	static float kernel_f[2][127];
+	static int16_t kernel_i[2][127];
+
+	for (i = 0; i < SAMPLE_COUNT; i++)
+	{
+		raw[i] = (uint16_t) (next_random() & 0xfff);
+	}
+	for (i = 0; i < SAMPLE_COUNT * 3 / 8; i++)
+	{
+		packed[i] = next_random();
+	}
+
+	// Half scale with a DC offset, and full scale 12 bit samples as converted by convert_samples_int16()
+	for (i = 0; i < BUFFER_COUNT * SAMPLE_COUNT; i++)
+	{
+		input_i[i] = (int16_t) ((int) (next_random() % 32768) - 16384 + 500);
+		input_f[i] = input_i[i] / 32768.0f;
+		full_i[i] = (int16_t) (((int) (next_random() & 0xfff) - 2048) * 16);
+		full_f[i] = full_i[i] / 32768.0f;
+	}
+
+	make_float_kernel(kernel_f[0], 127, 1);
+	make_float_kernel(kernel_f[1], 31, 0);
+	make_int16_kernel(kernel_i[0], 127, 1);
+	make_int16_kernel(kernel_i[1], 31, 0);
+
+	printf("CPU features 0x%02x\n", detected);
+
+	for (s = 0; s < KERNEL_SET_COUNT; s++)
+	{
+		kernel_set = kernel_sets[s];
+		if ((kernel_set & detected) != kernel_set)
+		{
+			continue;
+		}
+
+		check_sample_converter(kernel_set, raw, packed);
+
+		check_float(kernel_set, HB_KERNEL_FLOAT, HB_KERNEL_FLOAT_LEN, input_f, "half-band 47");
+		check_float(kernel_set, HB_KERNEL_FLOAT, HB_KERNEL_FLOAT_LEN, full_f, "half-band 47, full scale");
+		check_float(kernel_set, kernel_f[0], 127, input_f, "symmetric 127");
+		check_float(kernel_set, kernel_f[1], 31, input_f, "asymmetric 31");
+
+		check_int16(kernel_set, HB_KERNEL_INT16, HB_KERNEL_INT16_LEN, input_i, "half-band 47");
+		check_int16(kernel_set, HB_KERNEL_INT16, HB_KERNEL_INT16_LEN, full_i, "half-band 47, full scale");
+		check_int16(kernel_set, kernel_i[0], 127, full_i, "symmetric 127, full scale");
+		check_int16(kernel_set, kernel_i[0], 127, input_i, "symmetric 127");
+		check_int16(kernel_set, kernel_i[1], 31, input_i, "asymmetric 31");
+	}
+
+	if (failures != 0)
+	{
+		printf("%d check(s) failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}